@@ -1,7 +1,537 @@
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fnmatch.h>
+#endif
 #include <ubench/ubench.hpp>
+#include <chineseroom/batch.hpp>
+#include <chineseroom/compiled_pattern.hpp>
+#include <chineseroom/field_projection.hpp>
+#include <chineseroom/glob_map.hpp>
+#include <chineseroom/pattern_image.hpp>
+#include <chineseroom/grep.hpp>
+#include <chineseroom/pattern_list.hpp>
+#include <chineseroom/topic_router.hpp>
+#include <chineseroom/pattern_set.hpp>
+#include <chineseroom/split.hpp>
+#include <chineseroom/static_pattern.hpp>
+#include <chineseroom/wildcards.hpp>
+
+
+namespace chr = chineseroom;
+
+
+std::string random_word(std::mt19937& rng, std::size_t size) {
+  std::string word;
+  for(std::size_t i = 0; i != size; ++i)
+    word.push_back(char('a' + rng() % 26));
+  return word;
+}
+
+
+// 80% of literals, the rest are 'prefix*', '*suffix' and '*middle*'
+std::vector<std::string> mixed_patterns(std::mt19937& rng, std::size_t n) {
+  std::vector<std::string> patterns;
+  patterns.reserve(n);
+  for(std::size_t i = 0; i != n; ++i) {
+    std::string word = random_word(rng, 8 + rng() % 8);
+    switch(rng() % 10) {
+      case 0:
+        patterns.push_back(word + "*");
+        continue;
+      case 1:
+        patterns.push_back("*." + word);
+        continue;
+      default:
+        patterns.push_back(std::move(word));
+        continue;
+    }
+  }
+  patterns.back() = "*" + random_word(rng, 6) + "*";
+  return patterns;
+}
+
+
+void benchmark_mixed_lists() {
+  std::mt19937 rng{1};
+  bool matched = false;
+
+  for(std::size_t n = 100; n <= 1000000; n *= 10) {
+    auto const patterns = mixed_patterns(rng, n);
+    chr::pattern_set const set{patterns};
+    std::string const hit = patterns[n / 2];
+    std::string const miss = random_word(rng, 12);
+
+    auto const linear = ubench::run([&]{ matched = chr::selected(patterns, miss) != matched; });
+    auto const indexed_miss = ubench::run([&]{ matched = set.matched_any(miss) != matched; });
+    auto const indexed_hit = ubench::run([&]{ matched = set.matched_any(hit) != matched; });
+
+    std::cout << n << " patterns\n"
+              << "  selected (list):           " << linear << '\n'
+              << "  pattern_set (miss):        " << indexed_miss << '\n'
+              << "  pattern_set (literal hit): " << indexed_hit << '\n';
+  }
+
+  if(matched)
+    std::cout << '\n';
+}
+
+
+void benchmark_comma_separated_lists() {
+  std::string const spec{"*.example.com,*.example.org,mail.*,localhost,"
+                         "127.0.0.1,api.v?.*,!*.internal.*,!admin.*"};
+  std::string const text{"www.example.org"};
+  chr::pattern_list const list{spec};
+  bool matched = false;
+
+  auto const splitted = ubench::run([&]{
+    matched = chr::selected(chr::split(spec, ','), text) != matched;
+  });
+  auto const in_place = ubench::run([&]{ matched = chr::selected(spec, text) != matched; });
+  auto const compiled = ubench::run([&]{ matched = list.matched_any(text) != matched; });
+
+  std::cout << "comma separated list of " << list.size() << " patterns\n"
+            << "  split and match:           " << splitted << '\n'
+            << "  match in place:            " << in_place << '\n'
+            << "  pattern_list:              " << compiled << '\n';
+
+  if(matched)
+    std::cout << '\n';
+}
+
+
+// URL filter rules with wildcards on both sides
+std::vector<std::string> url_rules(std::mt19937& rng, std::size_t n) {
+  std::vector<std::string> rules;
+  rules.reserve(n);
+  for(std::size_t i = 0; i != n; ++i) {
+    std::string const word = random_word(rng, 4 + rng() % 6);
+    switch(rng() % 3) {
+      case 0:
+        rules.push_back("*/" + word + "/*");
+        continue;
+      case 1:
+        rules.push_back("http?://" + word + ".*");
+        continue;
+      default:
+        rules.push_back("*[?&]" + word + "=*");
+        continue;
+    }
+  }
+  return rules;
+}
+
+
+void benchmark_text_signatures() {
+  std::mt19937 rng{2};
+  auto const rules = url_rules(rng, 50000);
+  chr::pattern_list const list{rules};
+  std::vector<chr::compiled_pattern> compiled;
+  for(auto const& each: rules)
+    compiled.emplace_back(each);
+  std::string const url{"https://www.example.com/static/images/logo.png?v=12"};
+  bool matched = false;
+
+  auto const plain = ubench::run([&]{
+    bool any = false;
+    for(auto const& each: compiled)
+      if(each.matched_body(url)) {
+        any = true;
+        break;
+      }
+    matched = any != matched;
+  });
+  auto const screened = ubench::run([&]{ matched = list.matched_any(url) != matched; });
+
+  std::cout << rules.size() << " URL rules\n"
+            << "  compiled patterns:         " << plain << '\n'
+            << "  screened by signature:     " << screened << '\n';
+
+  if(matched)
+    std::cout << '\n';
+}
+
+
+void benchmark_set_updates() {
+  std::mt19937 rng{3};
+  auto const patterns = mixed_patterns(rng, 1000000);
+  chr::pattern_set set{patterns};
+  std::vector<std::string> updates;
+  for(std::size_t i = 0; i != 1000; ++i)
+    updates.push_back("*" + random_word(rng, 8) + "*." + random_word(rng, 3));
+
+  auto const started = std::chrono::steady_clock::now();
+  chr::pattern_set const rebuilt{patterns};
+  auto const built = std::chrono::steady_clock::now();
+  std::vector<std::uint32_t> ids;
+  for(auto const& each: updates)
+    ids.push_back(set.insert(each));
+  for(std::uint32_t each: ids)
+    set.remove(each);
+  auto const updated = std::chrono::steady_clock::now();
+
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+  std::cout << rebuilt.size() << " patterns\n"
+            << "  rebuild:                   "
+            << duration_cast<microseconds>(built - started).count() << " us\n"
+            << "  insert and remove:         "
+            << duration_cast<microseconds>(updated - built).count() / (2 * updates.size())
+            << " us per pattern\n\n";
+}
+
+
+void benchmark_glob_map() {
+  std::mt19937 rng{4};
+  auto const patterns = mixed_patterns(rng, 100000);
+  chr::glob_map<std::size_t> routes;
+  std::unordered_map<std::string, std::size_t> hashed;
+  for(std::size_t i = 0; i != patterns.size(); ++i) {
+    routes.insert_or_assign(patterns[i], i);
+    hashed.emplace(patterns[i], i);
+  }
+  std::string const literal = patterns[patterns.size() / 2];
+  std::string const miss = random_word(rng, 12);
+  std::size_t found = 0;
+
+  auto const map = ubench::run([&]{ found += hashed.find(literal)->second; });
+  auto const exact = ubench::run([&]{ found += *routes.find(literal); });
+  auto const wildcard = ubench::run([&]{ found += routes.find(miss) != nullptr; });
+
+  std::cout << patterns.size() << " glob_map routes\n"
+            << "  unordered_map (literal):   " << map << '\n'
+            << "  glob_map (literal):        " << exact << '\n'
+            << "  glob_map (miss):           " << wildcard << '\n';
+
+  if(found == 0)
+    std::cout << '\n';
+}
+
+
+// matching of split subscription and subject with per segment wildcards
+bool subscribed(std::vector<std::string> const& filter,
+                std::vector<std::string> const& subject) {
+  for(std::size_t i = 0; i != filter.size(); ++i) {
+    if(filter[i] == ">")
+      return subject.size() > i;
+    if(i == subject.size() || !chr::matched(filter[i], subject[i]))
+      return false;
+  }
+  return filter.size() == subject.size();
+}
+
+
+void benchmark_topic_router() {
+  std::mt19937 rng{5};
+  char const* const regions[] = {"eu", "us", "asia", "*"};
+
+  for(std::size_t n = 10000; n <= 1000000; n *= 10) {
+    chr::topic_router<std::size_t> router;
+    std::vector<std::vector<std::string>> filters;
+    for(std::size_t i = 0; i != n; ++i) {
+      std::string filter = std::string{"svc"} + std::to_string(rng() % (n / 4))
+        + '.' + regions[rng() % 4] + (rng() % 8 == 0 ? ".>" : ".orders");
+      router.subscribe(filter, i);
+      filters.push_back(chr::split(filter, '.'));
+    }
+    std::string const subject = "svc" + std::to_string(n / 8) + ".eu.orders";
+    std::size_t found = 0;
+
+    auto const trie = ubench::run([&]{
+      router.match(subject, [&found](std::size_t each) { found += each; });
+    });
+    std::cout << n << " subscriptions\n";
+    if(n == 10000) {
+      auto const linear = ubench::run([&]{
+        auto const segments = chr::split(subject, '.');
+        for(std::size_t i = 0; i != filters.size(); ++i)
+          if(subscribed(filters[i], segments))
+            found += i;
+      });
+      std::cout << "  split and match:           " << linear << '\n';
+    }
+    std::cout << "  topic_router:              " << trie << '\n';
+    if(found == 0)
+      std::cout << '\n';
+  }
+}
+
+
+void benchmark_search() {
+  std::mt19937 rng{6};
+  std::string log;
+  while(log.size() < (1 << 24)) {
+    log += "2020-01-01 12:00:00 INFO " + random_word(rng, 20 + rng() % 40) + '\n';
+    if(rng() % 1000 == 0)
+      log += "2020-01-01 12:00:00 ERROR timeout of " + random_word(rng, 8) + '\n';
+  }
+  chr::compiled_pattern const pattern{"ERROR t?meout of *\n"};
+  std::size_t found = 0;
+
+  auto const anchored = ubench::run([&]{
+    pattern.find_all(log, [&found](chr::capture) { ++found; return true; });
+  });
+
+  std::cout << "search in " << (log.size() >> 20) << " MiB of log\n"
+            << "  find_all:                  " << anchored << '\n';
+
+  if(found == 0)
+    std::cout << '\n';
+}
+
+
+void benchmark_batches() {
+  std::mt19937 rng{7};
+  std::string buffer;
+  std::vector<std::size_t> offsets{0};
+  for(std::size_t i = 0; i != (1 << 22); ++i) {
+    buffer += random_word(rng, 4 + rng() % 12);
+    offsets.push_back(buffer.size());
+  }
+  chr::text_column const column{buffer.data(), offsets.data(), offsets.size() - 1};
+  chr::compiled_pattern const pattern{"ab*c?d"};
+  std::vector<std::uint64_t> bits;
+  std::vector<bool> flags(column.size());
+
+  auto const one_by_one = ubench::run([&]{
+    for(std::size_t i = 0; i != column.size(); ++i)
+      flags[i] = pattern.matched(column[i]);
+  });
+  auto const single = ubench::run([&]{ chr::matched_batch(pattern, column, bits, 1); });
+  auto const parallel = ubench::run([&]{ chr::matched_batch(pattern, column, bits); });
+
+  std::cout << column.size() << " texts in column\n"
+            << "  matched one by one:        " << one_by_one << '\n'
+            << "  matched_batch (1 thread):  " << single << '\n'
+            << "  matched_batch:             " << parallel << '\n';
+}
+
+
+void benchmark_grep() {
+  std::mt19937 rng{8};
+  std::string log;
+  while(log.size() < (std::size_t(1) << 26)) {
+    log += "2020-01-01 12:00:00 " + std::string{rng() % 100 == 0 ? "ERROR " : "INFO "}
+         + random_word(rng, 20 + rng() % 40) + '\n';
+  }
+  std::vector<std::string> const patterns{"*ERROR*timeout*", "*ERROR*refused*",
+                                          "*ERROR*a", "!*debug*"};
+  chr::pattern_set const set{patterns};
+  std::size_t found = 0;
+
+  chr::grep_options single;
+  single.threads = 1;
+  auto const one_thread = ubench::run([&]{ found += chr::count_lines(set, log, single); });
+  auto const all_threads = ubench::run([&]{ found += chr::count_lines(set, log); });
+
+  std::cout << "grep " << (log.size() >> 20) << " MiB of log\n";
+#if defined(__unix__) || defined(__APPLE__)
+  auto const posix = ubench::run([&]{
+    chr::detail::for_each_line(log, [&](std::string_view line) {
+      std::string const text{line};
+      bool included = false;
+      for(auto const& each: patterns)
+        if(each[0] == '!') {
+          if(fnmatch(each.c_str() + 1, text.c_str(), 0) == 0) {
+            included = false;
+            break;
+          }
+        } else if(!included)
+          included = fnmatch(each.c_str(), text.c_str(), 0) == 0;
+      found += included;
+    });
+  });
+  std::cout << "  fnmatch per line:          " << posix << '\n';
+#endif
+  std::cout << "  count_lines (1 thread):    " << one_thread << '\n'
+            << "  count_lines:               " << all_threads << '\n';
+
+  if(found == 0)
+    std::cout << '\n';
+}
+
+
+void benchmark_field_projection() {
+  std::mt19937 rng{9};
+  std::string table;
+  while(table.size() < (std::size_t(1) << 24)) {
+    for(int field = 1; field != 10; ++field)
+      table += (field == 7 ? random_word(rng, 2) + ".example.com" : random_word(rng, 4 + rng() % 12)) + '\t';
+    table += random_word(rng, 8) + '\n';
+  }
+  chr::pattern_set const hosts{"a*.example.com", "!ab.*"};
+  chr::field_projection const projection{7, {1, 3, 7}};
+  std::size_t found = 0;
+
+  auto const split_rows = ubench::run([&]{
+    std::string out;
+    std::vector<std::string> fields;
+    chr::detail::for_each_line(table, [&](std::string_view line) {
+      chr::split_strictly(std::string{line}, '\t', fields);
+      if(fields.size() < 7 || !hosts.matched_any(fields[6]))
+        return;
+      out += fields[0] + '\t' + fields[2] + '\t' + fields[6] + '\n';
+    });
+    found += out.size();
+  });
+
+  chr::grep_options single;
+  single.threads = 1;
+  auto const projected = ubench::run([&]{
+    found += chr::project_lines(hosts, table, projection, single).size();
+  });
+
+  std::cout << "select fields 1, 3, 7 by field 7 of " << (table.size() >> 20) << " MiB\n"
+            << "  split every row:           " << split_rows << '\n'
+            << "  project_lines (1 thread):  " << projected << '\n';
+
+  if(found == 0)
+    std::cout << '\n';
+}
+
+
+constexpr chr::static_pattern system_file{"/etc/*.con?"};
+
+
+void benchmark_static_patterns() {
+  std::mt19937 rng{10};
+  std::vector<std::string> paths;
+  for(std::size_t i = 0; i != 1 << 20; ++i)
+    paths.push_back((rng() % 2 == 0 ? "/etc/" : "/usr/") + random_word(rng, 4 + rng() % 12)
+                    + (rng() % 2 == 0 ? ".conf" : ".txt"));
+  chr::compiled_pattern const compiled{"/etc/*.con?"};
+  std::size_t found = 0;
+
+  auto const dynamic = ubench::run([&]{
+    for(auto const& each: paths)
+      found += compiled.matched(each);
+  });
+  auto const unrolled = ubench::run([&]{
+    for(auto const& each: paths)
+      found += chr::matched<system_file>(each);
+  });
+  auto const handwritten = ubench::run([&]{
+    for(auto const& each: paths)
+      found += each.size() >= 10 && std::memcmp(each.data(), "/etc/", 5) == 0
+               && std::memcmp(each.data() + each.size() - 5, ".con", 4) == 0;
+  });
+
+  std::cout << "match " << paths.size() << " paths by /etc/*.con?\n"
+            << "  compiled_pattern:          " << dynamic << '\n'
+            << "  static_pattern:            " << unrolled << '\n'
+            << "  memcmp by hand:            " << handwritten << '\n';
+
+  if(found == 0)
+    std::cout << '\n';
+}
+
+
+void benchmark_pattern_images() {
+  std::mt19937 rng{11};
+  auto const patterns = mixed_patterns(rng, 1000000);
+  std::string const literal = patterns[patterns.size() / 2];
+  std::string const miss = random_word(rng, 12);
+
+  auto const started = std::chrono::steady_clock::now();
+  chr::pattern_set const set{patterns};
+  auto const built = std::chrono::steady_clock::now();
+  std::string const bytes = chr::pattern_image::make(patterns);
+  auto const made = std::chrono::steady_clock::now();
+  chr::pattern_image const image{bytes};
+  auto const opened = std::chrono::steady_clock::now();
+
+  std::size_t found = 0;
+  auto const set_hit = ubench::run([&]{ found += set.matched_any(literal); });
+  auto const image_hit = ubench::run([&]{ found += image.matched_any(literal); });
+  auto const set_miss = ubench::run([&]{ found += set.matched_any(miss); });
+  auto const image_miss = ubench::run([&]{ found += image.matched_any(miss); });
+
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+  std::cout << image.size() << " patterns in image of " << (bytes.size() >> 20) << " MiB\n"
+            << "  pattern_set build:         "
+            << duration_cast<microseconds>(built - started).count() << " us\n"
+            << "  pattern_image make:        "
+            << duration_cast<microseconds>(made - built).count() << " us\n"
+            << "  pattern_image open:        "
+            << duration_cast<microseconds>(opened - made).count() << " us\n"
+            << "  pattern_set (literal hit): " << set_hit << '\n'
+            << "  image (literal hit):       " << image_hit << '\n'
+            << "  pattern_set (miss):        " << set_miss << '\n'
+            << "  image (miss):              " << image_miss << '\n';
+
+  if(found == 0)
+    std::cout << '\n';
+}
+
+
+void benchmark_memory() {
+  std::mt19937 rng{12};
+  auto const patterns = mixed_patterns(rng, 1000000);
+  std::size_t strings = patterns.capacity() * sizeof(std::string);
+  std::size_t compiled = 0;
+  for(auto const& each: patterns) {
+    strings += chr::detail::allocated(each);
+    compiled += sizeof(chr::compiled_pattern) + chr::compiled_pattern{each}.allocated();
+  }
+  chr::pattern_set const set{patterns};
+  chr::memory_usage const usage = set.memory();
+
+  std::cout << patterns.size() << " patterns in memory\n"
+            << "  std::vector<std::string>:  " << (strings >> 20) << " MiB\n"
+            << "  compiled one by one:       " << (compiled >> 20) << " MiB\n"
+            << "  pattern_set texts:         " << (usage.texts >> 20) << " MiB\n"
+            << "  pattern_set patterns:      " << (usage.patterns >> 20) << " MiB\n"
+            << "  pattern_set indexes:       " << (usage.indexes >> 20) << " MiB\n\n";
+}
+
+
+void benchmark_parallel_build() {
+  std::mt19937 rng{13};
+  unsigned const hardware = std::max(1u, std::thread::hardware_concurrency());
+  for(std::size_t n = 1000000; n <= 10000000; n *= 10) {
+    auto const patterns = mixed_patterns(rng, n);
+    std::cout << n << " patterns built by threads\n";
+    std::size_t indexes = 0;
+    for(unsigned threads: {1u, 2u, 4u, hardware}) {
+      auto const started = std::chrono::steady_clock::now();
+      chr::pattern_set const set{patterns, threads};
+      auto const built = std::chrono::steady_clock::now();
+      // the same set for any number of threads
+      if(indexes != 0 && indexes != set.memory().indexes)
+        std::cout << "  sets differ\n";
+      indexes = set.memory().indexes;
+      std::cout << "  " << threads << " of " << hardware << ":  "
+                << std::chrono::duration_cast<std::chrono::milliseconds>(built - started).count()
+                << " ms\n";
+    }
+  }
+  std::cout << '\n';
+}
 
 
 int main() {
+  benchmark_comma_separated_lists();
+  benchmark_parallel_build();
+  benchmark_memory();
+  benchmark_pattern_images();
+  benchmark_static_patterns();
+  benchmark_field_projection();
+  benchmark_grep();
+  benchmark_batches();
+  benchmark_search();
+  benchmark_topic_router();
+  benchmark_glob_map();
+  benchmark_set_updates();
+  benchmark_text_signatures();
+  benchmark_mixed_lists();
   return 0;
 }
@@ -0,0 +1,111 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+#include <chineseroom/grep.hpp>
+#include <chineseroom/mapped_file.hpp>
+#include <chineseroom/pattern_set.hpp>
+#include <chineseroom/split.hpp>
+
+
+namespace chr = chineseroom;
+
+
+int usage() {
+  std::cerr << "usage: chineseroom-grep [-c] [-v] [-j threads] "
+               "[-e pattern]... patterns [file]...\n"
+               "  patterns   comma separated list, '!' patterns exclude lines,\n"
+               "             always the first argument that isn't an option\n"
+               "  -e         one more pattern, may contain ',' or start with '-'\n"
+               "  -c         print number of selected lines\n"
+               "  -v         select lines not matched\n"
+               "  -j         number of threads, all hardware threads by default\n";
+  return 2;
+}
+
+
+int run(int argc, char* argv[]) {
+  chr::grep_options options;
+  bool counting = false;
+  bool listed = false;
+  std::vector<std::string> patterns;
+  std::vector<char const*> files;
+
+  for(int i = 1; i != argc; ++i) {
+    if(std::strcmp(argv[i], "-c") == 0)
+      counting = true;
+    else if(std::strcmp(argv[i], "-v") == 0)
+      options.inverted = true;
+    else if(std::strcmp(argv[i], "-j") == 0 && i + 1 != argc)
+      options.threads = unsigned(std::atoi(argv[++i]));
+    else if(std::strcmp(argv[i], "-e") == 0 && i + 1 != argc)
+      patterns.emplace_back(argv[++i]);
+    else if(argv[i][0] == '-' && argv[i][1] != '\0')
+      return usage();
+    else if(!listed) {
+      listed = true;
+      for(std::string& each: chr::split(std::string{argv[i]}, ','))
+        patterns.push_back(std::move(each));
+    } else
+      files.push_back(argv[i]);
+  }
+
+  if(!listed || patterns.empty())
+    return usage();
+
+  chr::pattern_set const set{patterns};
+  bool const named = files.size() > 1;
+  bool selected = false;
+
+  auto const process = [&](char const* name, std::string_view text) {
+    std::string const prefix = named ? std::string{name} + ':' : std::string{};
+    if(counting) {
+      std::size_t const count = chr::count_lines(set, text, options);
+      selected = selected || count != 0;
+      std::cout << prefix << count << '\n';
+      return;
+    }
+    chr::grep_lines(set, text, [&](std::string_view line) {
+      selected = true;
+      std::cout << prefix << line << '\n';
+    }, options);
+  };
+
+  std::ios::sync_with_stdio(false);
+
+  if(files.empty()) {
+    std::string const input{std::istreambuf_iterator<char>{std::cin},
+                            std::istreambuf_iterator<char>{}};
+    process("-", input);
+  }
+
+  int status = 0;
+  for(char const* each: files) {
+    chr::mapped_file const file{each};
+    if(!file.is_open()) {
+      std::cerr << "chineseroom-grep: can't open " << each << '\n';
+      status = 2;
+      continue;
+    }
+    process(each, file.view());
+  }
+
+  std::cout.flush();
+  return status != 0 ? status : selected ? 0 : 1;
+}
+
+
+int main(int argc, char* argv[]) {
+  try {
+    return run(argc, argv);
+  } catch(std::exception const& e) {
+    std::cout.flush();
+    std::cerr << "chineseroom-grep: " << e.what() << '\n';
+    return 2;
+  }
+}
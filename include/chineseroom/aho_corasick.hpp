@@ -0,0 +1,212 @@
+/* This file is part of chineseroom library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+
+namespace chineseroom {
+
+
+// Multiple literal search. Literals are added first, then the automaton is
+// built once and scanned over texts reporting (literal id, end offset) of
+// every occurrence. Identical literals share the same id.
+class aho_corasick {
+public:
+
+  static constexpr std::uint32_t none = std::uint32_t(-1);
+
+
+  aho_corasick() {
+    nodes_.emplace_back();
+    children_.emplace_back();
+    root_.fill(0);
+  }
+
+
+  std::size_t size() const noexcept { return literals_; }
+  bool empty() const noexcept { return literals_ == 0; }
+  bool built() const noexcept { return built_; }
+
+
+  // heap bytes taken by the automaton
+  std::size_t allocated() const noexcept {
+    std::size_t bytes = nodes_.capacity() * sizeof(node) + edges_.capacity() * sizeof(edge)
+                      + children_.capacity() * sizeof(std::vector<edge>);
+    for(auto const& each: children_)
+      bytes += each.capacity() * sizeof(edge);
+    return bytes;
+  }
+
+
+  std::uint32_t add(std::string_view literal) {
+    built_ = false;
+    std::uint32_t state = 0;
+    for(char c: literal) {
+      unsigned char const u = static_cast<unsigned char>(c);
+      std::uint32_t next = child(state, u);
+      if(next == none) {
+        next = std::uint32_t(nodes_.size());
+        nodes_.emplace_back();
+        children_.emplace_back();
+        auto& edges = children_[state];
+        edges.insert(std::upper_bound(edges.begin(), edges.end(), edge{u, 0}),
+                     edge{u, next});
+      }
+      state = next;
+    }
+    if(nodes_[state].output == none)
+      nodes_[state].output = std::uint32_t(literals_++);
+    return nodes_[state].output;
+  }
+
+
+  // id of added literal or none, works before build() as well
+  std::uint32_t find(std::string_view literal) const noexcept {
+    std::uint32_t state = 0;
+    for(char c: literal) {
+      state = child(state, static_cast<unsigned char>(c));
+      if(state == none)
+        return none;
+    }
+    return nodes_[state].output;
+  }
+
+
+  void build() {
+    if(built_)
+      return;
+
+    // flatten edges so every state keeps them in one contiguous sorted run
+    edges_.clear();
+    for(std::uint32_t i = 0; i != nodes_.size(); ++i) {
+      nodes_[i].first_edge = std::uint32_t(edges_.size());
+      edges_.insert(edges_.end(), children_[i].begin(), children_[i].end());
+      nodes_[i].edge_count = std::uint32_t(edges_.size()) - nodes_[i].first_edge;
+    }
+
+    root_.fill(0);
+    for(std::uint32_t e = 0; e != nodes_[0].edge_count; ++e)
+      root_[edges_[e].symbol] = edges_[e].target;
+
+    // breadth first failure and dictionary links
+    std::vector<std::uint32_t> queue;
+    queue.reserve(nodes_.size());
+    for(std::uint32_t e = 0; e != nodes_[0].edge_count; ++e) {
+      node& n = nodes_[edges_[e].target];
+      n.fail = 0;
+      n.dictionary = none;
+      queue.push_back(edges_[e].target);
+    }
+
+    for(std::size_t head = 0; head != queue.size(); ++head) {
+      std::uint32_t const state = queue[head];
+      node const& parent = nodes_[state];
+      for(std::uint32_t e = 0; e != parent.edge_count; ++e) {
+        edge const& each = edges_[parent.first_edge + e];
+        std::uint32_t const fail = next_state(nodes_[state].fail, each.symbol);
+        node& n = nodes_[each.target];
+        n.fail = fail;
+        n.dictionary = nodes_[fail].output != none ? fail : nodes_[fail].dictionary;
+        queue.push_back(each.target);
+      }
+    }
+
+    built_ = true;
+  }
+
+
+  // calls f(literal_id, end_offset) for every occurrence, stops when f
+  // returns false; returns false if it was stopped
+  template<typename F> bool scan(std::string_view text, F&& f) const {
+    std::uint32_t state = 0;
+    for(std::size_t i = 0; i != text.size(); ++i) {
+      state = next_state(state, static_cast<unsigned char>(text[i]));
+      if(state == 0)
+        continue;
+      std::uint32_t found = nodes_[state].output != none ? state : nodes_[state].dictionary;
+      for(; found != none; found = nodes_[found].dictionary)
+        if(!f(nodes_[found].output, i + 1))
+          return false;
+    }
+    return true;
+  }
+
+
+private:
+
+  struct edge {
+    unsigned char symbol;
+    std::uint32_t target;
+
+    friend bool operator < (edge const& lhs, edge const& rhs) noexcept {
+      return lhs.symbol < rhs.symbol;
+    }
+  };
+
+  struct node {
+    std::uint32_t first_edge{0};
+    std::uint32_t edge_count{0};
+    std::uint32_t fail{0};
+    std::uint32_t dictionary{none};
+    std::uint32_t output{none};
+  };
+
+  std::vector<node> nodes_;
+  std::vector<edge> edges_;
+  std::array<std::uint32_t, 256> root_;
+  std::vector<std::vector<edge>> children_;
+  std::size_t literals_{0};
+  bool built_{false};
+
+
+  std::uint32_t child(std::uint32_t state, unsigned char symbol) const noexcept {
+    auto const& edges = children_[state];
+    auto const it = std::lower_bound(edges.begin(), edges.end(), edge{symbol, 0});
+    return it != edges.end() && it->symbol == symbol ? it->target : none;
+  }
+
+
+  std::uint32_t next_state(std::uint32_t state, unsigned char symbol) const noexcept {
+    for(;;) {
+      if(state == 0)
+        return root_[symbol];
+      node const& n = nodes_[state];
+      edge const* const first = edges_.data() + n.first_edge;
+      edge const* const last = first + n.edge_count;
+      edge const* const it = std::lower_bound(first, last, edge{symbol, 0});
+      if(it != last && it->symbol == symbol)
+        return it->target;
+      state = n.fail;
+    }
+  }
+
+}; // aho_corasick
+
+
+} // chineseroom
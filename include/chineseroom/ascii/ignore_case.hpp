@@ -0,0 +1,147 @@
+/* This file is part of chineseroom library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CHINESEROOM_SSE2
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+namespace chineseroom::ascii {
+
+
+  // tag to select comparison of ASCII letters regardless of their case
+  struct ignore_case_t {
+    explicit ignore_case_t() = default;
+  };
+
+  inline constexpr ignore_case_t ignore_case{};
+
+
+namespace detail {
+
+  constexpr std::array<unsigned char, 256> make_lower_case_table() noexcept {
+    std::array<unsigned char, 256> table{};
+    for(unsigned c = 0; c != 256; ++c)
+      table[c] = static_cast<unsigned char>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+    return table;
+  }
+
+  inline constexpr std::array<unsigned char, 256> lower_case_table = make_lower_case_table();
+
+
+  inline unsigned lowest_bit(unsigned bits) noexcept {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return unsigned(index);
+#else
+    return unsigned(__builtin_ctz(bits));
+#endif
+  }
+
+
+  inline unsigned lowest_bit64(unsigned long long bits) noexcept {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return unsigned(index);
+#else
+    return unsigned(__builtin_ctzll(bits));
+#endif
+  }
+
+} // detail
+
+
+  constexpr char to_lower(char c) noexcept {
+    return static_cast<char>(detail::lower_case_table[static_cast<unsigned char>(c)]);
+  }
+
+
+  constexpr bool equal_ignoring_case(char lhs, char rhs) noexcept {
+    return to_lower(lhs) == to_lower(rhs);
+  }
+
+
+  inline bool equal_ignoring_case(char const* lhs, char const* rhs, std::size_t n) noexcept {
+    for(std::size_t i = 0; i != n; ++i)
+      if(to_lower(lhs[i]) != to_lower(rhs[i]))
+        return false;
+    return true;
+  }
+
+
+  // position of the first occurrence of needle in text regardless of case of
+  // letters or std::string_view::npos
+  inline std::size_t find_ignoring_case(std::string_view text,
+                                        std::string_view needle) noexcept {
+    if(needle.empty())
+      return 0;
+
+    if(needle.size() > text.size())
+      return std::string_view::npos;
+
+    std::size_t const candidates = text.size() - needle.size() + 1;
+    char const first = to_lower(needle.front());
+    char const* const data = text.data();
+    std::size_t i = 0;
+
+#ifdef CHINESEROOM_SSE2
+    // setting 0x20 bit turns upper case letters to lower case ones and
+    // never turns any other character to a lower case letter
+    bool const letter = first >= 'a' && first <= 'z';
+    __m128i const mask = _mm_set1_epi8(letter ? 0x20 : 0);
+    __m128i const wanted = _mm_set1_epi8(first);
+    for(; i + 16 <= candidates; i += 16) {
+      __m128i const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + i));
+      unsigned bits = unsigned(_mm_movemask_epi8(
+        _mm_cmpeq_epi8(_mm_or_si128(chunk, mask), wanted)));
+      for(; bits != 0; bits &= bits - 1) {
+        std::size_t const at = i + detail::lowest_bit(bits);
+        if(equal_ignoring_case(data + at + 1, needle.data() + 1, needle.size() - 1))
+          return at;
+      }
+    }
+#endif
+
+    for(; i != candidates; ++i)
+      if(to_lower(data[i]) == first
+         && equal_ignoring_case(data + i + 1, needle.data() + 1, needle.size() - 1))
+        return i;
+
+    return std::string_view::npos;
+  }
+
+
+} // chineseroom::ascii
@@ -0,0 +1,222 @@
+/* This file is part of chineseroom library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "ascii/ignore_case.hpp"
+#include "compiled_pattern.hpp"
+
+
+namespace chineseroom {
+
+
+// Column of texts stored one after another in one buffer, text i takes
+// [offsets[i], offsets[i + 1]), so there are size + 1 offsets
+class text_column {
+public:
+
+  text_column(char const* data, std::size_t const* offsets, std::size_t size) noexcept:
+    data_{data}, offsets_{offsets}, size_{size}
+  { }
+
+
+  std::size_t size() const noexcept { return size_; }
+
+  std::string_view operator [] (std::size_t i) const noexcept {
+    return std::string_view{data_ + offsets_[i], offsets_[i + 1] - offsets_[i]};
+  }
+
+  std::size_t text_size(std::size_t i) const noexcept {
+    return offsets_[i + 1] - offsets_[i];
+  }
+
+
+private:
+
+  char const* data_;
+  std::size_t const* offsets_;
+  std::size_t size_;
+
+}; // text_column
+
+
+namespace detail {
+
+  inline void prefetch(void const* address) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#else
+    (void)address;
+#endif
+  }
+
+
+  // checks of length, first and last characters done for a block of 64
+  // texts before matching the ones passed them
+  class batch_filter {
+  public:
+
+    explicit batch_filter(compiled_pattern const& pattern) noexcept:
+      min_length_{pattern.min_length()},
+      max_length_{pattern.starred() ? std::size_t(-1) : pattern.min_length()},
+      folded_{pattern.ignoring_case()} {
+      std::string_view const head = pattern.head();
+      std::string_view const tail = pattern.tail();
+      headed_ = !head.empty();
+      tailed_ = !tail.empty();
+      first_ = headed_ ? lowered(head.front()) : 0;
+      last_ = tailed_ ? lowered(tail.back()) : 0;
+    }
+
+
+    template<typename T>
+    std::uint64_t passed(T const& texts, std::size_t first, std::size_t count) const noexcept {
+      std::uint64_t bits = 0;
+      // sizes only, so the loop is vectorized for columns
+      for(std::size_t i = 0; i != count; ++i) {
+        std::size_t const n = size_of(texts, first + i);
+        bits |= std::uint64_t(n >= min_length_ && n <= max_length_) << i;
+      }
+      if(!headed_ && !tailed_)
+        return bits;
+      for(std::uint64_t rest = bits; rest != 0; rest &= rest - 1) {
+        std::size_t const i = ascii::detail::lowest_bit64(rest);
+        std::string_view const text = texts[first + i];
+        if((headed_ && lowered(text.front()) != first_)
+           || (tailed_ && lowered(text.back()) != last_))
+          bits &= ~(std::uint64_t(1) << i);
+      }
+      return bits;
+    }
+
+
+  private:
+
+    std::size_t min_length_;
+    std::size_t max_length_;
+    bool folded_;
+    bool headed_{false};
+    bool tailed_{false};
+    char first_{0};
+    char last_{0};
+
+
+    char lowered(char c) const noexcept {
+      return folded_ ? ascii::to_lower(c) : c;
+    }
+
+
+    static std::size_t size_of(text_column const& texts, std::size_t i) noexcept {
+      return texts.text_size(i);
+    }
+
+
+    template<typename T>
+    static std::size_t size_of(T const& texts, std::size_t i) noexcept {
+      return std::string_view{texts[i]}.size();
+    }
+  }; // batch_filter
+
+
+  template<typename T>
+  void matched_blocks(compiled_pattern const& pattern, batch_filter const& filter,
+                      T const& texts, std::size_t size,
+                      std::size_t first_block, std::size_t last_block,
+                      std::uint64_t* bits) noexcept {
+    std::uint64_t const negated = pattern.negated() ? ~std::uint64_t(0) : 0;
+    for(std::size_t block = first_block; block != last_block; ++block) {
+      std::size_t const first = block * 64;
+      std::size_t const count = std::min<std::size_t>(64, size - first);
+      std::uint64_t passed = filter.passed(texts, first, count);
+      std::uint64_t matched = 0;
+      for(std::uint64_t rest = passed; rest != 0; rest &= rest - 1) {
+        std::size_t const i = ascii::detail::lowest_bit64(rest);
+        // the next candidate is loaded while this one is matched
+        std::uint64_t const next = rest & (rest - 1);
+        if(next != 0)
+          prefetch(std::string_view{texts[first + ascii::detail::lowest_bit64(next)]}.data());
+        if(pattern.matched_body(texts[first + i]))
+          matched |= std::uint64_t(1) << i;
+      }
+      std::uint64_t const valid = count == 64 ? ~std::uint64_t(0)
+                                              : (std::uint64_t(1) << count) - 1;
+      bits[block] = (matched ^ negated) & valid;
+    }
+  }
+
+
+  template<typename T>
+  void matched_batch(compiled_pattern const& pattern, T const& texts, std::size_t size,
+                     std::vector<std::uint64_t>& bits, unsigned threads) {
+    std::size_t const blocks = (size + 63) / 64;
+    bits.assign(blocks, 0);
+    batch_filter const filter{pattern};
+
+    if(threads == 0)
+      threads = size < (std::size_t(1) << 16) ? 1 : std::max(1u, std::thread::hardware_concurrency());
+    threads = unsigned(std::min<std::size_t>(threads, blocks));
+    if(threads <= 1) {
+      matched_blocks(pattern, filter, texts, size, 0, blocks, bits.data());
+      return;
+    }
+
+    // every thread writes words of its own blocks only
+    std::vector<std::thread> workers;
+    std::size_t const per_thread = (blocks + threads - 1) / threads;
+    for(std::size_t first = 0; first < blocks; first += per_thread) {
+      std::size_t const last = std::min(blocks, first + per_thread);
+      workers.emplace_back([&, first, last] {
+        matched_blocks(pattern, filter, texts, size, first, last, bits.data());
+      });
+    }
+    for(std::thread& each: workers)
+      each.join();
+  }
+
+} // detail
+
+
+// Matches every text by the pattern and sets bit i % 64 of bits[i / 64]
+// when text i is matched. Texts are checked by length, first and last
+// characters 64 at a time before matching; batches of 64k texts and more
+// are split between hardware threads unless threads is given.
+template<typename R>
+void matched_batch(compiled_pattern const& pattern, R const& texts,
+                   std::vector<std::uint64_t>& bits, unsigned threads = 0) {
+  detail::matched_batch(pattern, texts, std::size(texts), bits, threads);
+}
+
+
+inline void matched_batch(compiled_pattern const& pattern, text_column const& texts,
+                          std::vector<std::uint64_t>& bits, unsigned threads = 0) {
+  detail::matched_batch(pattern, texts, texts.size(), bits, threads);
+}
+
+
+} // chineseroom
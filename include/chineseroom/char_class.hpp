@@ -0,0 +1,92 @@
+/* This file is part of chineseroom library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+
+#include <array>
+#include <cstdint>
+
+
+namespace chineseroom {
+
+
+// 256-bit membership bitmap of bytes matched by '[...]' class of a pattern
+class char_class {
+public:
+
+  constexpr bool test(char c) const noexcept {
+    unsigned char const u = static_cast<unsigned char>(c);
+    return (words_[u >> 6] >> (u & 63)) & 1;
+  }
+
+
+  constexpr void set(char c) noexcept {
+    unsigned char const u = static_cast<unsigned char>(c);
+    words_[u >> 6] |= std::uint64_t(1) << (u & 63);
+  }
+
+
+  constexpr void set(char first, char last) noexcept {
+    unsigned const from = static_cast<unsigned char>(first);
+    unsigned const to = static_cast<unsigned char>(last);
+    for(unsigned u = from; u <= to; ++u)
+      set(static_cast<char>(u));
+  }
+
+
+  constexpr void invert() noexcept {
+    for(auto& each: words_)
+      each = ~each;
+  }
+
+
+  // adds other case of every ASCII letter of the class
+  constexpr void fold_case() noexcept {
+    for(char c = 'a'; c <= 'z'; ++c) {
+      char const upper = static_cast<char>(c - 'a' + 'A');
+      if(test(c) || test(upper)) {
+        set(c);
+        set(upper);
+      }
+    }
+  }
+
+
+  friend bool operator == (char_class const& lhs, char_class const& rhs) noexcept {
+    return lhs.words_ == rhs.words_;
+  }
+
+
+  friend bool operator != (char_class const& lhs, char_class const& rhs) noexcept {
+    return !(lhs == rhs);
+  }
+
+
+private:
+
+  std::array<std::uint64_t, 4> words_{};
+
+}; // char_class
+
+
+} // chineseroom
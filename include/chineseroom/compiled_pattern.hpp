@@ -0,0 +1,537 @@
+/* This file is part of chineseroom library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "ascii/ignore_case.hpp"
+#include "char_class.hpp"
+#include "text_signature.hpp"
+#include "wildcards.hpp"
+
+
+namespace chineseroom {
+
+
+namespace detail {
+
+  // heap bytes of the string, short ones are kept inside of it
+  inline std::size_t allocated(std::string const& s) noexcept {
+    return s.capacity() >= sizeof(std::string) ? s.capacity() + 1 : 0;
+  }
+
+} // detail
+
+
+// Pattern parsed once into pieces separated by '*'. Matches exactly like
+// detail::matched, including leading '!' negation, but never backtracks:
+// the first piece is anchored at the start of the text, the last one at the
+// end, and the pieces between are searched leftmost-first. Every '[...]'
+// class is compiled to 256-bit bitmap and escaped characters are unescaped.
+class compiled_pattern {
+public:
+
+  // kind of atom, class atoms are numbered from class_atom
+  enum atom_kind : std::uint16_t {
+    literal_atom, any_atom, star_atom, class_atom
+  };
+
+
+  compiled_pattern() noexcept = default;
+  compiled_pattern(compiled_pattern const&) = default;
+  compiled_pattern& operator = (compiled_pattern const&) = default;
+  compiled_pattern(compiled_pattern&&) noexcept = default;
+  compiled_pattern& operator = (compiled_pattern&&) noexcept = default;
+
+
+  explicit compiled_pattern(std::string_view pattern):
+    compiled_pattern{pattern, false}
+  { }
+
+
+  // ASCII letters are matched regardless of their case
+  compiled_pattern(std::string_view pattern, ascii::ignore_case_t):
+    compiled_pattern{pattern, true}
+  { }
+
+
+  bool negated() const noexcept { return negated_; }
+  bool starred() const noexcept { return starred_; }
+  bool ignoring_case() const noexcept { return folded_; }
+  std::size_t min_length() const noexcept { return min_length_; }
+
+  // pattern without leading '!'
+  std::string_view body() const noexcept { return body_; }
+
+  // longest run of plain characters every matched body has to contain
+  std::string_view longest_literal() const noexcept {
+    return std::string_view{symbols_}.substr(literal_offset_, literal_size_);
+  }
+
+  // plain characters every matched body starts with
+  std::string_view head() const noexcept {
+    std::size_t i = 0;
+    while(i != symbols_.size() && atom(i) == literal_atom)
+      ++i;
+    return std::string_view{symbols_}.substr(0, i);
+  }
+
+  // plain characters every matched body ends with
+  std::string_view tail() const noexcept {
+    std::size_t i = symbols_.size();
+    while(i != 0 && atom(i - 1) == literal_atom)
+      --i;
+    return std::string_view{symbols_}.substr(i);
+  }
+
+  // pattern matching only one text, head() of it
+  bool literal() const noexcept {
+    return kinds_.empty();
+  }
+
+
+  // parsed pattern: one atom per character of matched text, and stars
+  std::size_t atoms() const noexcept { return symbols_.size(); }
+
+  std::uint16_t atom(std::size_t i) const noexcept {
+    return kinds_.empty() ? std::uint16_t(literal_atom) : kinds_[i];
+  }
+
+  // character of literal atom
+  char symbol(std::size_t i) const noexcept { return symbols_[i]; }
+
+  char_class const& atom_class(std::size_t i) const noexcept {
+    return classes_[kinds_[i] - class_atom];
+  }
+
+
+  bool matched(std::string_view text) const noexcept {
+    return matched_body(text) != negated_;
+  }
+
+
+  // stores spans of every '*', '?' and '[...]' like chineseroom::match_captures
+  bool match_captures(std::string_view text,
+                      capture* captures, std::size_t capacity) const noexcept {
+    return recorded_body(text, detail::capture_recorder{captures, capacity}) != negated_;
+  }
+
+
+  template<std::size_t N>
+  bool match_captures(std::string_view text, std::array<capture, N>& captures) const noexcept {
+    return match_captures(text, captures.data(), N);
+  }
+
+
+  // matching without taking negation into account
+  bool matched_body(std::string_view text) const noexcept {
+    return recorded_body(text, detail::no_captures{});
+  }
+
+
+  // Leftmost substring of the text starting at from or later matched by the
+  // body of the pattern, the shortest of such ones; stars at both ends of the
+  // pattern match empty text. Returns capture{npos, 0} if there is none.
+  capture find(std::string_view text, std::size_t from = 0) const noexcept {
+    capture const none{std::string_view::npos, 0};
+    if(from > text.size())
+      return none;
+
+    std::size_t first = 0;
+    std::size_t last = pieces_.size();
+    while(first != last && pieces_[first].size == 0)
+      ++first;
+    while(last != first && pieces_[last - 1].size == 0)
+      --last;
+    if(first == last)
+      return capture{from, 0};
+
+    // if the rest can't be placed after the leftmost first piece, it can't
+    // be placed after any later one
+    char const* const data = text.data();
+    std::size_t const start = find_piece(pieces_[first], data, from, text.size());
+    if(start == std::string_view::npos)
+      return none;
+    std::size_t end = start + pieces_[first].size;
+    for(std::size_t i = first + 1; i != last; ++i) {
+      piece const& each = pieces_[i];
+      if(each.size == 0)
+        continue;
+      std::size_t const found = find_piece(each, data, end, text.size());
+      if(found == std::string_view::npos)
+        return none;
+      end = found + each.size;
+    }
+    return capture{start, end - start};
+  }
+
+
+  // calls f(capture) for every not overlapping substring found by find()
+  // one after another, stops when f returns false
+  template<typename F> void find_all(std::string_view text, F&& f) const {
+    for(std::size_t from = 0; from <= text.size(); ) {
+      capture const found = find(text, from);
+      if(found.offset == std::string_view::npos || !f(found))
+        return;
+      from = found.offset + (found.size == 0 ? 1 : found.size);
+    }
+  }
+
+
+  // false when body can't match any text with the signature: the text is too
+  // short (long), lacks some plain character or starts (ends) with other one
+  bool admits(text_signature const& signature) const noexcept {
+    std::size_t const n = signature.size();
+    if(n < min_length_ || (!starred_ && n != min_length_))
+      return false;
+    if(!signature.contains(required_))
+      return false;
+    if(headed_ && !same(symbols_.front(), signature.first()))
+      return false;
+    if(tailed_ && !same(symbols_.back(), signature.last()))
+      return false;
+    return true;
+  }
+
+
+  // matched(text) for text with precomputed signature
+  bool matched(std::string_view text, text_signature const& signature) const noexcept {
+    return matched_body(text, signature) != negated_;
+  }
+
+
+  bool matched_body(std::string_view text, text_signature const& signature) const noexcept {
+    return admits(signature) && matched_body(text);
+  }
+
+
+  // heap bytes taken by the pattern
+  std::size_t allocated() const noexcept {
+    return detail::allocated(body_) + detail::allocated(symbols_)
+         + kinds_.capacity() * sizeof(std::uint16_t)
+         + classes_.capacity() * sizeof(char_class)
+         + pieces_.capacity() * sizeof(piece);
+  }
+
+
+private:
+
+  struct piece {
+    std::uint32_t offset;
+    std::uint32_t size;
+    bool exact;
+    // longest run of plain characters of not exact piece to search for
+    std::uint32_t anchor_offset;
+    std::uint32_t anchor_size;
+  };
+
+  std::string body_;
+  // character of every atom, escapes are removed
+  std::string symbols_;
+  // atom_kind of every atom or empty if all of them are literal
+  std::vector<std::uint16_t> kinds_;
+  std::vector<char_class> classes_;
+  std::vector<piece> pieces_;
+  std::size_t min_length_{0};
+  std::uint32_t literal_offset_{0};
+  std::uint32_t literal_size_{0};
+  // signature bits of every plain character
+  std::uint64_t required_{0};
+  bool negated_{false};
+  bool starred_{false};
+  bool folded_{false};
+  // the first (last) atom is a plain character
+  bool headed_{false};
+  bool tailed_{false};
+
+
+  compiled_pattern(std::string_view pattern, bool folded): folded_{folded} {
+    if(!pattern.empty() && pattern.front() == '!') {
+      negated_ = true;
+      pattern.remove_prefix(1);
+    }
+
+    body_ = pattern;
+    parse();
+
+    piece current{0, 0, true, 0, 0};
+    for(std::uint32_t i = 0; i != symbols_.size(); ++i)
+      switch(atom(i)) {
+        case literal_atom:
+          ++min_length_;
+          required_ |= detail::signature_bit(symbols_[i]);
+          continue;
+        case star_atom:
+          current.size = i - current.offset;
+          pieces_.push_back(current);
+          current = piece{i + 1, 0, true, 0, 0};
+          starred_ = true;
+          continue;
+        default:
+          current.exact = false;
+          ++min_length_;
+          continue;
+      }
+
+    current.size = std::uint32_t(symbols_.size()) - current.offset;
+    pieces_.push_back(current);
+
+    for(piece& each: pieces_)
+      if(!each.exact)
+        find_anchor(each);
+
+    headed_ = !symbols_.empty() && atom(0) == literal_atom;
+    tailed_ = !symbols_.empty() && atom(symbols_.size() - 1) == literal_atom;
+    find_longest_literal();
+  }
+
+
+  template<typename R>
+  bool recorded_body(std::string_view text, R&& recorder) const noexcept {
+    char const* const first = text.data();
+    std::size_t const n = text.size();
+    std::size_t wildcard = 0;
+
+    if(!starred_) {
+      if(n != min_length_ || !piece_matched(pieces_.front(), first))
+        return false;
+      record_singles(pieces_.front(), 0, wildcard, recorder);
+      return true;
+    }
+
+    if(n < min_length_)
+      return false;
+
+    piece const& head = pieces_.front();
+    piece const& tail = pieces_.back();
+
+    if(!piece_matched(head, first))
+      return false;
+
+    if(!piece_matched(tail, first + n - tail.size))
+      return false;
+
+    record_singles(head, 0, wildcard, recorder);
+    std::size_t from = head.size;
+    std::size_t const to = n - tail.size;
+
+    for(std::size_t i = 1; i + 1 < pieces_.size(); ++i) {
+      piece const& each = pieces_[i];
+      std::size_t const found = each.size == 0 ? from : find_piece(each, first, from, to);
+      if(found == std::string_view::npos)
+        return false;
+      recorder.open(wildcard, from);
+      recorder.close(wildcard++, found);
+      record_singles(each, found, wildcard, recorder);
+      from = found + each.size;
+    }
+
+    recorder.open(wildcard, from);
+    recorder.close(wildcard++, to);
+    record_singles(tail, to, wildcard, recorder);
+    return true;
+  }
+
+
+  template<typename R>
+  void record_singles(piece const& p, std::size_t at,
+                      std::size_t& wildcard, R&& recorder) const noexcept {
+    if constexpr(std::is_same_v<std::decay_t<R>, detail::no_captures>)
+      return;
+    if(p.exact)
+      return;
+    for(std::uint32_t i = 0; i != p.size; ++i)
+      if(kinds_[p.offset + i] != literal_atom) {
+        recorder.open(wildcard, at + i);
+        recorder.close(wildcard++, at + i + 1);
+      }
+  }
+
+
+  void push_atom(char symbol, std::uint16_t kind) {
+    symbols_.push_back(symbol);
+    kinds_.push_back(kind);
+  }
+
+
+  void parse() {
+    char const* p = body_.data();
+    char const* const end = p + body_.size();
+
+    while(p != end)
+      switch(*p) {
+        case '*':
+          push_atom('*', star_atom);
+          ++p;
+          continue;
+        case '?':
+          push_atom('?', any_atom);
+          ++p;
+          continue;
+        case '[': {
+          char_class members;
+          bool inverted = false;
+          char const* const closed = detail::parse_class(p, end, inverted,
+            [&members](char first, char last) { members.set(first, last); });
+          if(closed == nullptr) {
+            // not closed class is just '['
+            push_atom('[', literal_atom);
+            ++p;
+            continue;
+          }
+          if(folded_)
+            members.fold_case();
+          if(inverted)
+            members.invert();
+          classes_.push_back(members);
+          push_atom('[', std::uint16_t(class_atom + classes_.size() - 1));
+          p = closed;
+          continue;
+        }
+        case '\\':
+          // escaped character or '\' at the end of pattern
+          if(p + 1 != end)
+            ++p;
+          push_atom(*p++, literal_atom);
+          continue;
+        default:
+          push_atom(*p++, literal_atom);
+          continue;
+      }
+
+    if(std::all_of(kinds_.begin(), kinds_.end(),
+                   [](std::uint16_t kind) { return kind == literal_atom; }))
+      kinds_.clear();
+  }
+
+
+  void find_longest_literal() noexcept {
+    std::uint32_t start = 0;
+    for(std::uint32_t i = 0; i <= symbols_.size(); ++i) {
+      if(i != symbols_.size() && atom(i) == literal_atom)
+        continue;
+      if(i - start > literal_size_) {
+        literal_offset_ = start;
+        literal_size_ = i - start;
+      }
+      start = i + 1;
+    }
+  }
+
+
+  void find_anchor(piece& p) const noexcept {
+    std::uint32_t start = p.offset;
+    std::uint32_t const end = p.offset + p.size;
+    for(std::uint32_t i = p.offset; i <= end; ++i) {
+      if(i != end && atom(i) == literal_atom)
+        continue;
+      if(i - start > p.anchor_size) {
+        p.anchor_offset = start - p.offset;
+        p.anchor_size = i - start;
+      }
+      start = i + 1;
+    }
+  }
+
+
+  std::size_t find_literal(char const* text, std::size_t from, std::size_t to,
+                           std::uint32_t offset, std::uint32_t size) const noexcept {
+    std::string_view const where{text + from, to - from};
+    std::string_view const what{symbols_.data() + offset, size};
+    std::size_t const found = folded_ ? ascii::find_ignoring_case(where, what)
+                                      : where.find(what);
+    return found == std::string_view::npos ? found : from + found;
+  }
+
+
+  bool same(char symbol, char c) const noexcept {
+    return folded_ ? ascii::equal_ignoring_case(symbol, c) : symbol == c;
+  }
+
+
+  bool atom_matched(std::uint32_t i, char c) const noexcept {
+    switch(kinds_[i]) {
+      case literal_atom:
+        return same(symbols_[i], c);
+      case any_atom:
+        return true;
+      default:
+        return classes_[kinds_[i] - class_atom].test(c);
+    }
+  }
+
+
+  bool piece_matched(piece const& p, char const* text) const noexcept {
+    // text of empty piece may be null, memcmp takes no null even for no bytes
+    if(p.size == 0)
+      return true;
+    char const* pattern = symbols_.data() + p.offset;
+    if(p.exact)
+      return folded_ ? ascii::equal_ignoring_case(pattern, text, p.size)
+                     : std::memcmp(pattern, text, p.size) == 0;
+    for(std::uint32_t i = 0; i != p.size; ++i)
+      if(!atom_matched(p.offset + i, text[i]))
+        return false;
+    return true;
+  }
+
+
+  std::size_t find_piece(piece const& p, char const* text,
+                         std::size_t from, std::size_t to) const noexcept {
+    if(to - from < p.size)
+      return std::string_view::npos;
+
+    if(p.exact)
+      return find_literal(text, from, to, p.offset, p.size);
+
+    if(p.anchor_size != 0) {
+      // candidates are where the anchor occurs, it is searched only where
+      // the whole piece fits
+      std::size_t const tail = p.size - p.anchor_offset - p.anchor_size;
+      for(std::size_t at = from + p.anchor_offset; ; ++at) {
+        at = find_literal(text, at, to - tail, p.offset + p.anchor_offset, p.anchor_size);
+        if(at == std::string_view::npos)
+          return at;
+        if(piece_matched(p, text + at - p.anchor_offset))
+          return at - p.anchor_offset;
+      }
+    }
+
+    for(std::size_t i = from; i + p.size <= to; ++i)
+      if(piece_matched(p, text + i))
+        return i;
+
+    return std::string_view::npos;
+  }
+
+}; // compiled_pattern
+
+
+} // chineseroom
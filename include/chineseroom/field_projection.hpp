@@ -0,0 +1,181 @@
+/* This file is part of chineseroom library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "grep.hpp"
+
+
+namespace chineseroom {
+
+
+namespace detail {
+
+  // start of the field after n separators or nullptr if there are less
+  inline char const* skip_fields(char const* p, char const* end,
+                                 char separator, std::size_t n) noexcept {
+    for(; n != 0; --n) {
+      void const* const found = std::memchr(p, separator, std::size_t(end - p));
+      if(found == nullptr)
+        return nullptr;
+      p = static_cast<char const*>(found) + 1;
+    }
+    return p;
+  }
+
+
+  inline char const* field_end(char const* p, char const* end, char separator) noexcept {
+    void const* const found = std::memchr(p, separator, std::size_t(end - p));
+    return found == nullptr ? end : static_cast<char const*>(found);
+  }
+
+} // detail
+
+
+// Selection of records by a key field matched_any of a matcher and
+// projection of selected records to some of their fields. Fields are
+// numbered from 1 as by cut, fields missing in a record are empty and a
+// record without the key field is never selected.
+class field_projection {
+public:
+
+  field_projection(std::size_t key, std::vector<std::size_t> columns, char separator = '\t')
+    : key_{key}, columns_{std::move(columns)}, separator_{separator} {
+    // columns are found in one pass in order of their numbers
+    order_.resize(columns_.size());
+    for(std::size_t i = 0; i != order_.size(); ++i)
+      order_[i] = i;
+    std::stable_sort(order_.begin(), order_.end(), [this](std::size_t lhs, std::size_t rhs) {
+      return columns_[lhs] < columns_[rhs];
+    });
+  }
+
+
+  std::size_t key() const noexcept { return key_; }
+  std::vector<std::size_t> const& columns() const noexcept { return columns_; }
+  char separator() const noexcept { return separator_; }
+
+
+  // key field of the record, returns false if the record has no such
+  bool key_field(std::string_view record, std::string_view& field) const noexcept {
+    if(key_ == 0)
+      return false;
+    char const* const end = record.data() + record.size();
+    char const* const first = detail::skip_fields(record.data(), end, separator_, key_ - 1);
+    if(first == nullptr)
+      return false;
+    field = std::string_view{first, std::size_t(detail::field_end(first, end, separator_) - first)};
+    return true;
+  }
+
+
+  // Calls f(i, field) for i-th of the columns if the key field of the
+  // record is matched, in order of field numbers; fields of records
+  // not selected are never looked at after the key field
+  template<typename M, typename F>
+  bool select(M const& matcher, std::string_view record, F&& f) const {
+    std::string_view key;
+    if(!key_field(record, key) || !matcher.matched_any(key))
+      return false;
+
+    char const* p = record.data();
+    char const* const end = p + record.size();
+    std::size_t number = 1;
+    for(std::size_t i: order_) {
+      std::size_t const wanted = columns_[i];
+      if(p != nullptr && wanted >= number) {
+        p = detail::skip_fields(p, end, separator_, wanted - number);
+        number = wanted;
+      }
+      if(p == nullptr || wanted == 0) {
+        f(i, std::string_view{});
+        continue;
+      }
+      f(i, std::string_view{p, std::size_t(detail::field_end(p, end, separator_) - p)});
+    }
+    return true;
+  }
+
+
+  // appends columns of the record joined by the separator and '\n' if
+  // the record is selected
+  template<typename M>
+  bool select(M const& matcher, std::string_view record, std::string& out,
+              std::vector<std::string_view>& fields) const {
+    fields.resize(columns_.size());
+    if(!select(matcher, record, [&](std::size_t i, std::string_view field) { fields[i] = field; }))
+      return false;
+    for(std::size_t i = 0; i != fields.size(); ++i) {
+      if(i != 0)
+        out += separator_;
+      out.append(fields[i].data(), fields[i].size());
+    }
+    out += '\n';
+    return true;
+  }
+
+
+private:
+
+  std::size_t key_;
+  std::vector<std::size_t> columns_;
+  // indices of columns ordered by field numbers
+  std::vector<std::size_t> order_;
+  char separator_;
+
+}; // field_projection
+
+
+// Columns of every line of the text selected by the projection, lines are
+// processed in parallel and written in order of the text; inverted option
+// is not used, records have to be selected by the key field
+template<typename M>
+std::string project_lines(M const& matcher, std::string_view text,
+                          field_projection const& projection,
+                          grep_options const& options = grep_options{}) {
+  auto const chunks = detail::line_chunks(text, options.chunk_size);
+  std::vector<std::string> outputs(chunks.size());
+  detail::run_chunks(chunks.size(), options.threads, [&](std::size_t i) {
+    std::vector<std::string_view> fields;
+    detail::for_each_line(chunks[i], [&](std::string_view line) {
+      projection.select(matcher, line, outputs[i], fields);
+    });
+  });
+  std::size_t size = 0;
+  for(auto const& each: outputs)
+    size += each.size();
+  std::string joined;
+  joined.reserve(size);
+  for(auto const& each: outputs)
+    joined += each;
+  return joined;
+}
+
+
+} // chineseroom
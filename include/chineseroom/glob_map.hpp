@@ -0,0 +1,186 @@
+/* This file is part of chineseroom library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "pattern_index.hpp"
+
+
+namespace chineseroom {
+
+
+// Map of patterns to values looked up by a key matched by patterns. The most
+// specific of matched patterns wins: the one with more plain characters, then
+// the one with fewer stars, then the least of pattern texts. Pattern without
+// wildcards is found by hash and beats every other pattern matching the key.
+// '!' patterns are least specific and match keys their body does not match.
+template<typename T> class glob_map {
+public:
+
+  glob_map() = default;
+
+
+  glob_map(std::initializer_list<std::pair<char const*, T>> entries) {
+    for(auto const& each: entries)
+      assign(each.first, each.second, false);
+    index_.build();
+  }
+
+
+  std::size_t size() const noexcept { return index_.size(); }
+  bool empty() const noexcept { return index_.empty(); }
+
+
+  // adds pattern with the value or replaces value of the same pattern
+  void insert_or_assign(std::string_view pattern, T value) {
+    assign(pattern, std::move(value), true);
+  }
+
+
+  bool erase(std::string_view pattern) {
+    auto const it = ids_.find(std::string{pattern});
+    if(it == ids_.end())
+      return false;
+    std::uint32_t const id = it->second;
+    ids_.erase(it);
+    if(index_.negated(id))
+      negated_.erase(std::find(negated_.begin(), negated_.end(), id));
+    entries_[id].reset();
+    return index_.remove(id);
+  }
+
+
+  // value of the most specific pattern matching the key or nullptr
+  T const* find(std::string_view key) const {
+    std::uint32_t best = none;
+    visit(key, [&](std::uint32_t id) {
+      if(index_.literal(id) && !index_.negated(id)) {
+        best = id;
+        return false;
+      }
+      if(best == none || more_specific(id, best))
+        best = id;
+      return true;
+    });
+    return best == none ? nullptr : &entries_[best]->value;
+  }
+
+
+  // values of every pattern matching the key, the most specific first
+  std::vector<T const*> find_all(std::string_view key) const {
+    std::vector<std::uint32_t> ids;
+    visit(key, [&ids](std::uint32_t id) {
+      ids.push_back(id);
+      return true;
+    });
+    std::sort(ids.begin(), ids.end(), [this](std::uint32_t lhs, std::uint32_t rhs) {
+      return more_specific(lhs, rhs);
+    });
+    std::vector<T const*> values;
+    values.reserve(ids.size());
+    for(std::uint32_t id: ids)
+      values.push_back(&entries_[id]->value);
+    return values;
+  }
+
+
+private:
+
+  static constexpr std::uint32_t none = std::uint32_t(-1);
+
+  struct entry {
+    T value;
+    std::uint32_t literals;
+    std::uint32_t stars;
+  };
+
+  pattern_index index_;
+  // by pattern id
+  std::vector<std::optional<entry>> entries_;
+  std::unordered_map<std::string, std::uint32_t> ids_;
+  // '!' patterns are checked for every key
+  std::vector<std::uint32_t> negated_;
+
+
+  void assign(std::string_view pattern, T value, bool patched) {
+    auto const found = ids_.find(std::string{pattern});
+    if(found != ids_.end()) {
+      entries_[found->second]->value = std::move(value);
+      return;
+    }
+
+    std::uint32_t const id = patched ? index_.insert(pattern) : index_.add(pattern);
+    ids_.emplace(std::string{pattern}, id);
+    if(entries_.size() <= id)
+      entries_.resize(id + 1);
+
+    compiled_pattern const p{pattern};
+    entry e{std::move(value), 0, 0};
+    for(std::size_t i = 0; i != p.atoms(); ++i)
+      if(p.atom(i) == compiled_pattern::star_atom)
+        ++e.stars;
+      else if(p.atom(i) == compiled_pattern::literal_atom && !p.negated())
+        ++e.literals;
+    entries_[id].emplace(std::move(e));
+
+    if(p.negated())
+      negated_.push_back(id);
+  }
+
+
+  // calls f(id) for every pattern matching the key until f returns false
+  template<typename F> void visit(std::string_view key, F&& f) const {
+    auto const plain = [this](std::uint32_t id) { return !index_.negated(id); };
+    if(!index_.matched(key, plain, f))
+      return;
+    for(std::uint32_t id: negated_)
+      if(!index_.matched_body(id, key) && !f(id))
+        return;
+  }
+
+
+  bool more_specific(std::uint32_t lhs, std::uint32_t rhs) const noexcept {
+    entry const& l = *entries_[lhs];
+    entry const& r = *entries_[rhs];
+    if(l.literals != r.literals)
+      return l.literals > r.literals;
+    if(index_.negated(lhs) != index_.negated(rhs))
+      return index_.negated(rhs);
+    if(l.stars != r.stars)
+      return l.stars < r.stars;
+    return index_.body(lhs) < index_.body(rhs);
+  }
+
+}; // glob_map
+
+
+} // chineseroom
@@ -0,0 +1,117 @@
+/* This file is part of chineseroom library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <vector>
+#include "parallel.hpp"
+
+
+namespace chineseroom {
+
+
+struct grep_options {
+  // 0 to use every hardware thread
+  unsigned threads{0};
+  // size of pieces of text taken by threads
+  std::size_t chunk_size{std::size_t(1) << 20};
+  // select lines not matched
+  bool inverted{false};
+};
+
+
+namespace detail {
+
+  // calls f(line) for every line of the text without '\n'
+  template<typename F> void for_each_line(std::string_view text, F&& f) {
+    char const* p = text.data();
+    char const* const end = p + text.size();
+    while(p != end) {
+      char const* const eol = static_cast<char const*>(std::memchr(p, '\n', std::size_t(end - p)));
+      char const* const last = eol == nullptr ? end : eol;
+      f(std::string_view{p, std::size_t(last - p)});
+      p = eol == nullptr ? end : eol + 1;
+    }
+  }
+
+
+  // text cut to pieces of about chunk_size ending with '\n'
+  inline std::vector<std::string_view> line_chunks(std::string_view text, std::size_t chunk_size) {
+    std::vector<std::string_view> chunks;
+    chunk_size = std::max<std::size_t>(chunk_size, 1);
+    while(!text.empty()) {
+      std::size_t size = std::min(chunk_size, text.size());
+      std::size_t const eol = text.find('\n', size - 1);
+      size = eol == std::string_view::npos ? text.size() : eol + 1;
+      chunks.push_back(text.substr(0, size));
+      text.remove_prefix(size);
+    }
+    return chunks;
+  }
+
+} // detail
+
+
+// Number of lines of the text matched_any of the matcher, e.g. pattern_set
+template<typename M>
+std::size_t count_lines(M const& matcher, std::string_view text,
+                        grep_options const& options = grep_options{}) {
+  auto const chunks = detail::line_chunks(text, options.chunk_size);
+  std::vector<std::size_t> counts(chunks.size());
+  detail::run_chunks(chunks.size(), options.threads, [&](std::size_t i) {
+    std::size_t count = 0;
+    detail::for_each_line(chunks[i], [&](std::string_view line) {
+      count += matcher.matched_any(line) != options.inverted;
+    });
+    counts[i] = count;
+  });
+  std::size_t total = 0;
+  for(std::size_t each: counts)
+    total += each;
+  return total;
+}
+
+
+// Calls f(line) for every line of the text matched_any of the matcher in
+// order of lines; lines are matched in parallel and reported by the caller
+template<typename M, typename F>
+void grep_lines(M const& matcher, std::string_view text, F&& f,
+                grep_options const& options = grep_options{}) {
+  auto const chunks = detail::line_chunks(text, options.chunk_size);
+  std::vector<std::vector<std::string_view>> selected(chunks.size());
+  detail::run_chunks(chunks.size(), options.threads, [&](std::size_t i) {
+    detail::for_each_line(chunks[i], [&](std::string_view line) {
+      if(matcher.matched_any(line) != options.inverted)
+        selected[i].push_back(line);
+    });
+  });
+  for(auto const& lines: selected)
+    for(std::string_view line: lines)
+      f(line);
+}
+
+
+} // chineseroom
@@ -0,0 +1,140 @@
+/* This file is part of chineseroom library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+
+namespace chineseroom {
+
+
+// Open addressing hash table of pattern ids by their literal text. Only
+// hashes are stored: lookup takes a function returning the literal of a
+// pattern id, so the index stays valid while the owner moves literals around.
+class literal_index {
+public:
+
+  std::size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0; }
+
+  // heap bytes taken by the index
+  std::size_t allocated() const noexcept { return slots_.capacity() * sizeof(slot); }
+
+
+  void insert(std::string_view literal, std::uint32_t id) {
+    if((size_ + 1) * 4 > slots_.size() * 3)
+      grow(slots_.empty() ? 16 : slots_.size() * 2);
+    place(slot{hash(literal), id});
+    ++size_;
+  }
+
+
+  // removes id inserted with the literal, returns false if there is no such
+  bool erase(std::string_view literal, std::uint32_t id) noexcept {
+    if(size_ == 0)
+      return false;
+    std::uint32_t const h = hash(literal);
+    std::size_t const mask = slots_.size() - 1;
+    std::size_t i = std::size_t(h) & mask;
+    for(; slots_[i].id != empty_id; i = (i + 1) & mask)
+      if(slots_[i].hash == h && slots_[i].id == id)
+        break;
+    if(slots_[i].id == empty_id)
+      return false;
+
+    // shift back following slots which can't be found past the hole
+    for(std::size_t j = (i + 1) & mask; slots_[j].id != empty_id; j = (j + 1) & mask) {
+      std::size_t const home = std::size_t(slots_[j].hash) & mask;
+      if(((j - home) & mask) >= ((j - i) & mask)) {
+        slots_[i] = slots_[j];
+        i = j;
+      }
+    }
+    slots_[i] = slot{0, empty_id};
+    --size_;
+    return true;
+  }
+
+
+  // calls f(id) for every pattern whose literal equals text, stops when f
+  // returns false; returns false if it was stopped
+  template<typename G, typename F>
+  bool find(std::string_view text, G&& get, F&& f) const {
+    if(size_ == 0)
+      return true;
+    std::uint32_t const h = hash(text);
+    std::size_t const mask = slots_.size() - 1;
+    for(std::size_t i = std::size_t(h) & mask; slots_[i].id != empty_id; i = (i + 1) & mask)
+      if(slots_[i].hash == h && get(slots_[i].id) == text)
+        if(!f(slots_[i].id))
+          return false;
+    return true;
+  }
+
+
+private:
+
+  static constexpr std::uint32_t empty_id = std::uint32_t(-1);
+
+  struct slot {
+    std::uint32_t hash;
+    std::uint32_t id;
+  };
+
+  std::vector<slot> slots_;
+  std::size_t size_{0};
+
+
+  // 32 bits are enough to place and screen literals, equal hashes are
+  // compared by text
+  static std::uint32_t hash(std::string_view text) noexcept {
+    std::uint64_t const h = std::uint64_t(std::hash<std::string_view>{}(text));
+    return std::uint32_t(h ^ (h >> 32));
+  }
+
+
+  void place(slot const& s) noexcept {
+    std::size_t const mask = slots_.size() - 1;
+    std::size_t i = std::size_t(s.hash) & mask;
+    while(slots_[i].id != empty_id)
+      i = (i + 1) & mask;
+    slots_[i] = s;
+  }
+
+
+  void grow(std::size_t capacity) {
+    std::vector<slot> previous(capacity, slot{0, empty_id});
+    previous.swap(slots_);
+    for(slot const& each: previous)
+      if(each.id != empty_id)
+        place(each);
+  }
+
+}; // literal_index
+
+
+} // chineseroom
@@ -0,0 +1,199 @@
+/* This file is part of chineseroom library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+
+namespace chineseroom {
+
+
+enum class direction { forward, backward };
+
+
+// Trie of pattern ids by a literal the text has to start with (forward) or to
+// end with (backward). Walking the text visits ids of every literal that is
+// a prefix (suffix) of the text. Edges of every node are kept in one open
+// addressing table by node and symbol, so a node takes no memory of its own
+// but the head of its ids.
+template<direction D> class literal_trie {
+public:
+
+  literal_trie() {
+    nodes_.push_back(none);
+  }
+
+
+  std::size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0; }
+
+
+  // heap bytes taken by the trie
+  std::size_t allocated() const noexcept {
+    return nodes_.capacity() * sizeof(std::uint32_t) + ids_.capacity() * sizeof(entry)
+         + edges_.capacity() * sizeof(edge);
+  }
+
+
+  void insert(std::string_view literal, std::uint32_t id) {
+    std::uint32_t state = 0;
+    for(std::size_t i = 0; i != literal.size(); ++i) {
+      std::uint32_t next = child(state, at(literal, i));
+      if(next == none) {
+        next = std::uint32_t(nodes_.size());
+        nodes_.push_back(none);
+        add_edge(state, at(literal, i), next);
+      }
+      state = next;
+    }
+    std::uint32_t e = free_;
+    if(e == none) {
+      e = std::uint32_t(ids_.size());
+      ids_.emplace_back();
+    } else
+      free_ = ids_[e].next;
+    ids_[e] = entry{id, nodes_[state]};
+    nodes_[state] = e;
+    ++size_;
+  }
+
+
+  // removes id inserted with the literal, returns false if there is no such;
+  // nodes stay in the trie and are reused by later inserts
+  bool erase(std::string_view literal, std::uint32_t id) noexcept {
+    std::uint32_t state = 0;
+    for(std::size_t i = 0; i != literal.size() && state != none; ++i)
+      state = child(state, at(literal, i));
+    if(state == none)
+      return false;
+    for(std::uint32_t* link = &nodes_[state]; *link != none; link = &ids_[*link].next)
+      if(ids_[*link].id == id) {
+        std::uint32_t const e = *link;
+        *link = ids_[e].next;
+        ids_[e].next = free_;
+        free_ = e;
+        --size_;
+        return true;
+      }
+    return false;
+  }
+
+
+  // calls f(id) for ids of every literal the text starts (ends) with, stops
+  // when f returns false; returns false if it was stopped
+  template<typename F> bool walk(std::string_view text, F&& f) const {
+    std::uint32_t state = 0;
+    for(std::size_t i = 0; ; ++i) {
+      for(std::uint32_t e = nodes_[state]; e != none; e = ids_[e].next)
+        if(!f(ids_[e].id))
+          return false;
+      if(i == text.size())
+        return true;
+      state = child(state, at(text, i));
+      if(state == none)
+        return true;
+    }
+  }
+
+
+private:
+
+  static constexpr std::uint32_t none = std::uint32_t(-1);
+
+  struct edge {
+    std::uint32_t state;
+    std::uint32_t target;
+    unsigned char symbol;
+  };
+
+  struct entry {
+    std::uint32_t id;
+    std::uint32_t next;
+  };
+
+  // the first entry of ids of every node
+  std::vector<std::uint32_t> nodes_;
+  std::vector<entry> ids_;
+  std::vector<edge> edges_;
+  // list of erased entries
+  std::uint32_t free_{none};
+  std::size_t size_{0};
+
+
+  static unsigned char at(std::string_view s, std::size_t i) noexcept {
+    if constexpr(D == direction::forward)
+      return static_cast<unsigned char>(s[i]);
+    else
+      return static_cast<unsigned char>(s[s.size() - 1 - i]);
+  }
+
+
+  static std::size_t slot_of(std::uint32_t state, unsigned char symbol, std::size_t mask) noexcept {
+    std::uint64_t const key = std::uint64_t(state) << 8 | symbol;
+    return std::size_t((key * 0x9e3779b97f4a7c15ull) >> 32) & mask;
+  }
+
+
+  std::uint32_t child(std::uint32_t state, unsigned char symbol) const noexcept {
+    if(edges_.empty())
+      return none;
+    std::size_t const mask = edges_.size() - 1;
+    for(std::size_t i = slot_of(state, symbol, mask); edges_[i].target != none; i = (i + 1) & mask)
+      if(edges_[i].state == state && edges_[i].symbol == symbol)
+        return edges_[i].target;
+    return none;
+  }
+
+
+  void add_edge(std::uint32_t state, unsigned char symbol, std::uint32_t target) {
+    // every node but the root is a target of one edge
+    if(nodes_.size() * 4 > edges_.size() * 3) {
+      std::vector<edge> previous(edges_.empty() ? 16 : edges_.size() * 2, edge{0, none, 0});
+      previous.swap(edges_);
+      for(edge const& each: previous)
+        if(each.target != none)
+          place(each);
+    }
+    place(edge{state, target, symbol});
+  }
+
+
+  void place(edge const& e) noexcept {
+    std::size_t const mask = edges_.size() - 1;
+    std::size_t i = slot_of(e.state, e.symbol, mask);
+    while(edges_[i].target != none)
+      i = (i + 1) & mask;
+    edges_[i] = e;
+  }
+
+}; // literal_trie
+
+
+using prefix_trie = literal_trie<direction::forward>;
+using suffix_trie = literal_trie<direction::backward>;
+
+
+} // chineseroom
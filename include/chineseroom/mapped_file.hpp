@@ -0,0 +1,140 @@
+/* This file is part of chineseroom library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CHINESEROOM_MMAP
+#else
+#include <fstream>
+#include <iterator>
+#endif
+
+
+namespace chineseroom {
+
+
+// Read only view of the whole file: mapped into memory where mmap is
+// available, read into a string otherwise
+class mapped_file {
+public:
+
+  mapped_file() noexcept = default;
+  mapped_file(mapped_file const&) = delete;
+  mapped_file& operator = (mapped_file const&) = delete;
+
+
+  explicit mapped_file(char const* path) {
+#ifdef CHINESEROOM_MMAP
+    int const fd = ::open(path, O_RDONLY);
+    if(fd == -1)
+      return;
+    struct stat status;
+    if(::fstat(fd, &status) == 0) {
+      opened_ = true;
+      size_ = std::size_t(status.st_size);
+      if(size_ != 0) {
+        void* const mapped = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(mapped == MAP_FAILED) {
+          opened_ = false;
+          size_ = 0;
+        } else {
+          data_ = static_cast<char const*>(mapped);
+          ::madvise(mapped, size_, MADV_SEQUENTIAL);
+        }
+      }
+    }
+    ::close(fd);
+#else
+    std::ifstream stream{path, std::ios::binary};
+    if(!stream)
+      return;
+    content_.assign(std::istreambuf_iterator<char>{stream}, std::istreambuf_iterator<char>{});
+    opened_ = true;
+    data_ = content_.data();
+    size_ = content_.size();
+#endif
+  }
+
+
+  mapped_file(mapped_file&& other) noexcept {
+    swap(other);
+  }
+
+
+  mapped_file& operator = (mapped_file&& other) noexcept {
+    mapped_file moved{std::move(other)};
+    swap(moved);
+    return *this;
+  }
+
+
+  ~mapped_file() {
+#ifdef CHINESEROOM_MMAP
+    if(data_ != nullptr)
+      ::munmap(const_cast<char*>(data_), size_);
+#endif
+  }
+
+
+  bool is_open() const noexcept { return opened_; }
+  std::size_t size() const noexcept { return size_; }
+
+  std::string_view view() const noexcept {
+    return std::string_view{data_, size_};
+  }
+
+
+private:
+
+  char const* data_{nullptr};
+  std::size_t size_{0};
+  bool opened_{false};
+#ifndef CHINESEROOM_MMAP
+  std::string content_;
+#endif
+
+
+  void swap(mapped_file& other) noexcept {
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    std::swap(opened_, other.opened_);
+#ifndef CHINESEROOM_MMAP
+    content_.swap(other.content_);
+    data_ = content_.data();
+    other.data_ = other.content_.data();
+#endif
+  }
+
+}; // mapped_file
+
+
+} // chineseroom
@@ -0,0 +1,80 @@
+/* This file is part of chineseroom library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace chineseroom {
+
+
+namespace detail {
+
+  // calls work(i) for every chunk index, threads take the next chunk not
+  // taken yet, so a thread stuck on a slow chunk doesn't hold the others;
+  // the first exception thrown by work stops taking chunks and is rethrown
+  // by the caller after every thread has finished
+  template<typename W> void run_chunks(std::size_t chunks, unsigned threads, W&& work) {
+    if(threads == 0)
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = unsigned(std::min<std::size_t>(threads, chunks));
+    if(threads <= 1) {
+      for(std::size_t i = 0; i != chunks; ++i)
+        work(i);
+      return;
+    }
+
+    std::atomic<std::size_t> next{0};
+    std::exception_ptr failure;
+    std::mutex failure_mutex;
+    auto const worker = [&] {
+      try {
+        for(std::size_t i = next++; i < chunks; i = next++)
+          work(i);
+      } catch(...) {
+        next = chunks;
+        std::lock_guard<std::mutex> const lock{failure_mutex};
+        if(!failure)
+          failure = std::current_exception();
+      }
+    };
+    std::vector<std::thread> workers;
+    for(unsigned i = 1; i != threads; ++i)
+      workers.emplace_back(worker);
+    worker();
+    for(std::thread& each: workers)
+      each.join();
+    if(failure)
+      std::rethrow_exception(failure);
+  }
+
+} // detail
+
+
+} // chineseroom
@@ -0,0 +1,269 @@
+/* This file is part of chineseroom library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "compiled_pattern.hpp"
+
+
+namespace chineseroom {
+
+
+// Pattern of '/' separated paths. Every segment of the pattern is matched
+// against one segment of the path, so '*', '?' and '[...]' never cross '/',
+// while the segment '**' matches zero or more whole segments: "src/**/*.cpp"
+// matches "src/a.cpp" and "src/a/b/c.cpp". Leading '!' negates the pattern.
+class path_pattern {
+public:
+
+  path_pattern() noexcept = default;
+
+
+  explicit path_pattern(std::string_view pattern) {
+    if(!pattern.empty() && pattern.front() == '!') {
+      negated_ = true;
+      pattern.remove_prefix(1);
+    }
+
+    std::size_t t = 0;
+    while(t != pattern.size() + 1) {
+      std::string_view const each = segment_at(pattern, t);
+      if(each == "**") {
+        // consecutive '**' are the same as one
+        if(segments_.empty() || !segments_.back().globstar)
+          segments_.push_back(segment{compiled_pattern{}, true});
+        continue;
+      }
+      // segment starting with '!' is not negated
+      segments_.push_back(segment{!each.empty() && each.front() == '!'
+        ? compiled_pattern{"\\" + std::string{each}}
+        : compiled_pattern{each}, false});
+    }
+  }
+
+
+  bool negated() const noexcept { return negated_; }
+
+
+  bool matched(std::string_view path) const noexcept {
+    return matched_body(path) != negated_;
+  }
+
+
+  // matching without taking negation into account; backtracks to the last
+  // '**' only, like detail::matched does to the last '*'
+  bool matched_body(std::string_view path) const noexcept {
+    std::size_t const n = segments_.size();
+    std::size_t const done = path.size() + 1;
+    std::size_t p = 0;
+    std::size_t t = 0;
+    std::size_t star = n;
+    std::size_t star_t = 0;
+
+    while(t != done) {
+      if(p != n && segments_[p].globstar) {
+        star = p++;
+        star_t = t;
+        continue;
+      }
+      if(p != n) {
+        std::size_t next = t;
+        if(segments_[p].glob.matched_body(segment_at(path, next))) {
+          ++p;
+          t = next;
+          continue;
+        }
+      }
+      if(star == n)
+        return false;
+      p = star + 1;
+      segment_at(path, star_t);
+      t = star_t;
+    }
+
+    while(p != n && segments_[p].globstar)
+      ++p;
+    return p == n;
+  }
+
+
+  // false when no path inside the directory can be matched, so a walker may
+  // skip it; the directory is given without trailing '/', empty for the root
+  bool could_match_under(std::string_view directory) const noexcept {
+    return negated_ ? !covers_all_under_body(directory)
+                    : could_match_under_body(directory);
+  }
+
+
+  // true when every path inside the directory is matched
+  bool covers_all_under(std::string_view directory) const noexcept {
+    return negated_ ? !could_match_under_body(directory)
+                    : covers_all_under_body(directory);
+  }
+
+
+private:
+
+  struct segment {
+    compiled_pattern glob;
+    bool globstar;
+  };
+
+  static constexpr std::size_t none = std::size_t(-1);
+  static constexpr std::size_t globstar = std::size_t(-2);
+
+  std::vector<segment> segments_;
+  bool negated_{false};
+
+
+  // segment starting at offset t, moves t past it and its '/'
+  static std::string_view segment_at(std::string_view path, std::size_t& t) noexcept {
+    std::size_t const last = path.find('/', t);
+    std::size_t const end = last == std::string_view::npos ? path.size() : last;
+    std::string_view const each = path.substr(t, end - t);
+    t = end + 1;
+    return each;
+  }
+
+
+  // index of pattern segment following directory segments, globstar when
+  // some '**' is reached, none when the directory is not matched
+  std::size_t walk(std::string_view directory) const noexcept {
+    if(!directory.empty() && directory.back() == '/')
+      directory.remove_suffix(1);
+    std::size_t p = 0;
+    if(directory.empty())
+      return p;
+    for(std::size_t t = 0; t != directory.size() + 1; ++p) {
+      if(p == segments_.size())
+        return none;
+      if(segments_[p].globstar)
+        return globstar;
+      if(!segments_[p].glob.matched_body(segment_at(directory, t)))
+        return none;
+    }
+    return p;
+  }
+
+
+  bool could_match_under_body(std::string_view directory) const noexcept {
+    std::size_t const p = walk(directory);
+    return p != none && (p == globstar || p < segments_.size());
+  }
+
+
+  // the directory leads to the last segment '**'
+  bool covers_all_under_body(std::string_view directory) const noexcept {
+    if(!directory.empty() && directory.back() == '/')
+      directory.remove_suffix(1);
+    std::size_t p = 0;
+    for(std::size_t t = 0; !directory.empty() && t != directory.size() + 1; ++p) {
+      if(p == segments_.size())
+        return false;
+      if(segments_[p].globstar)
+        return p + 1 == segments_.size();
+      if(!segments_[p].glob.matched_body(segment_at(directory, t)))
+        return false;
+    }
+    return p + 1 == segments_.size() && segments_[p].globstar;
+  }
+
+}; // path_pattern
+
+
+// List of path patterns with the meaning of selected(): a path is matched
+// when some pattern without '!' matches it (or there are no such patterns)
+// and no '!' pattern rejects it.
+class path_list {
+public:
+
+  path_list() = default;
+
+
+  explicit path_list(std::vector<std::string> const& patterns) {
+    for(auto const& each: patterns)
+      add(each);
+  }
+
+
+  path_list(std::initializer_list<char const*> patterns) {
+    for(auto const& each: patterns)
+      add(each);
+  }
+
+
+  std::size_t size() const noexcept { return patterns_.size(); }
+  bool empty() const noexcept { return patterns_.empty(); }
+
+  path_pattern const& operator [] (std::size_t i) const noexcept {
+    return patterns_[i];
+  }
+
+
+  bool matched_any(std::string_view path) const noexcept {
+    bool included = includes_ == 0;
+    for(path_pattern const& each: patterns_)
+      if(each.negated()) {
+        if(each.matched_body(path))
+          return false;
+      } else if(!included)
+        included = each.matched_body(path);
+    return included;
+  }
+
+
+  // false when no path inside the directory can be matched: no pattern
+  // without '!' can reach it or some '!' pattern rejects all of it
+  bool could_match_under(std::string_view directory) const noexcept {
+    bool reached = includes_ == 0;
+    for(path_pattern const& each: patterns_)
+      if(each.negated()) {
+        if(!each.could_match_under(directory))
+          return false;
+      } else if(!reached)
+        reached = each.could_match_under(directory);
+    return reached;
+  }
+
+
+private:
+
+  std::vector<path_pattern> patterns_;
+  std::size_t includes_{0};
+
+
+  void add(std::string_view pattern) {
+    patterns_.emplace_back(pattern);
+    if(!patterns_.back().negated())
+      ++includes_;
+  }
+
+}; // path_list
+
+
+} // chineseroom
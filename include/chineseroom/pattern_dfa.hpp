@@ -0,0 +1,495 @@
+/* This file is part of chineseroom library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "char_class.hpp"
+#include "compiled_pattern.hpp"
+#include "pattern_stream.hpp"
+#include "split.hpp"
+
+
+namespace chineseroom {
+
+
+// All patterns of the list are compiled into deterministic automata over the
+// union of their positions, so one pass over the text tells which patterns
+// matched it. '!' patterns are reported when their body does not match, as
+// detail::matched defines it. When the union automaton of some patterns grows
+// beyond max_states they are split into several automata by id ranges. A
+// single pattern whose own automaton grows beyond max_states, e.g. '*a???..',
+// is matched by compiled_pattern instead.
+class pattern_dfa {
+public:
+
+  static constexpr std::size_t default_max_states = 4096;
+
+
+  pattern_dfa() = default;
+
+
+  explicit pattern_dfa(std::vector<std::string> const& patterns,
+                       std::size_t max_states = default_max_states) {
+    for(auto const& each: patterns)
+      add(each);
+    build(max_states);
+  }
+
+
+  pattern_dfa(std::initializer_list<char const*> patterns) {
+    for(auto const& each: patterns)
+      add(each);
+    build(default_max_states);
+  }
+
+
+  // comma separated list of patterns
+  explicit pattern_dfa(std::string const& patterns,
+                       std::size_t max_states = default_max_states):
+    pattern_dfa{split(patterns, ','), max_states}
+  { }
+
+
+  std::size_t size() const noexcept { return negated_.size(); }
+  bool empty() const noexcept { return negated_.empty(); }
+
+  // number of automata the patterns were split into
+  std::size_t automata() const noexcept { return automata_.size(); }
+  // number of patterns matched without automata
+  std::size_t fallbacks() const noexcept { return fallbacks_.size(); }
+
+
+  // Resumable run of the automata over a text coming in several chunks, e.g.
+  // parts of a ring buffer; gives the same result as matching the text
+  // concatenated from the chunks.
+  class stream {
+  public:
+
+    explicit stream(pattern_dfa const& dfa): dfa_{&dfa} {
+      for(fallback const& each: dfa.fallbacks_)
+        fallbacks_.emplace_back(each.pattern);
+      reset();
+    }
+
+
+    void reset() {
+      states_.clear();
+      for(automaton const& each: dfa_->automata_)
+        states_.push_back(each.start);
+      for(pattern_stream& each: fallbacks_)
+        each.reset();
+    }
+
+
+    void feed(std::string_view chunk) noexcept {
+      for(std::size_t i = 0; i != states_.size(); ++i)
+        states_[i] = dfa_->automata_[i].run(states_[i], chunk, dfa_->classes_);
+      for(pattern_stream& each: fallbacks_)
+        each.feed(chunk);
+    }
+
+
+    // calls f(pattern_id) for every pattern matched by the text fed so far
+    template<typename F> void matched(F&& f) const {
+      dfa_->report_all([this](std::size_t i) { return states_[i]; },
+                       [this](std::size_t k) { return fallbacks_[k].matched(); }, f);
+    }
+
+
+    bool matched_any() const noexcept {
+      return dfa_->decide([this](std::size_t i) { return states_[i]; },
+                          [this](std::size_t k) { return fallbacks_[k].matched(); });
+    }
+
+
+  private:
+
+    pattern_dfa const* dfa_;
+    std::vector<std::uint32_t> states_;
+    std::vector<pattern_stream> fallbacks_;
+  }; // stream
+
+
+  // calls f(pattern_id) for every matched pattern in ascending order of ids
+  template<typename F> void matched(std::string_view text, F&& f) const {
+    report_all([&](std::size_t i) { return final_state(i, text); },
+               [&](std::size_t k) { return fallbacks_[k].pattern.matched(text); }, f);
+  }
+
+
+  void matched(std::string_view text, std::vector<bool>& bits) const {
+    bits.assign(size(), false);
+    matched(text, [&bits](std::size_t id) { bits[id] = true; });
+  }
+
+
+  // same meaning as selected() of the list
+  bool matched_any(std::string_view text) const {
+    return decide([&](std::size_t i) { return final_state(i, text); },
+                  [&](std::size_t k) { return fallbacks_[k].pattern.matched(text); });
+  }
+
+
+private:
+
+  enum position_type : std::uint8_t {
+    literal_position, any_position, class_position, star_position, end_position
+  };
+
+  struct position {
+    position_type type;
+    char symbol;
+    std::uint32_t pattern;
+    // index of char class for class position
+    std::uint32_t members;
+  };
+
+  struct state {
+    std::uint32_t first_accepted{0};
+    std::uint32_t accepted_count{0};
+    bool included{false};
+    bool excluded{false};
+  };
+
+  // state 0 is dead: no pattern can match anymore
+  struct automaton {
+    std::vector<std::uint32_t> transitions;
+    // the first pattern of the range
+    std::uint32_t first_id{0};
+    std::vector<state> states;
+    std::size_t class_count{0};
+    std::uint32_t start{0};
+    std::uint32_t first_negated{0};
+    std::uint32_t last_negated{0};
+
+    // state after the text starting from current one
+    std::uint32_t run(std::uint32_t current, std::string_view text,
+                      std::array<std::uint16_t, 256> const& classes) const noexcept {
+      if(current == 0)
+        return current;
+      for(char c: text) {
+        current = transitions[current * class_count + classes[static_cast<unsigned char>(c)]];
+        if(current == 0)
+          break;
+      }
+      return current;
+    }
+  };
+
+  // pattern too large for an automaton of its own
+  struct fallback {
+    std::uint32_t id;
+    compiled_pattern pattern;
+  };
+
+  std::vector<position> positions_;
+  std::vector<char_class> members_;
+  // first position of every pattern
+  std::vector<std::uint32_t> starts_;
+  std::vector<bool> negated_;
+  std::vector<std::uint32_t> negated_ids_;
+  std::vector<std::uint32_t> accepted_;
+  std::vector<automaton> automata_;
+  // in ascending order of ids
+  std::vector<fallback> fallbacks_;
+  // patterns kept until automata are built
+  std::vector<compiled_pattern> compiled_;
+  std::array<std::uint16_t, 256> classes_{};
+  std::vector<unsigned char> representatives_;
+  std::size_t includes_{0};
+
+
+  // calls f(pattern_id) for every pattern matched when the automaton has
+  // come to the state
+  template<typename F>
+  void report(automaton const& each, std::uint32_t current, F&& f) const {
+    state const& s = each.states[current];
+    std::uint32_t const* accepted = accepted_.data() + s.first_accepted;
+    std::uint32_t const* const accepted_end = accepted + s.accepted_count;
+    std::uint32_t const* negated = negated_ids_.data() + each.first_negated;
+    std::uint32_t const* const negated_end = negated_ids_.data() + each.last_negated;
+
+    // merge accepted bodies with ids of '!' patterns of the automaton
+    while(accepted != accepted_end || negated != negated_end)
+      if(negated == negated_end || (accepted != accepted_end && *accepted < *negated)) {
+        if(!negated_[*accepted])
+          f(std::size_t(*accepted));
+        ++accepted;
+      } else if(accepted == accepted_end || *negated < *accepted) {
+        f(std::size_t(*negated));
+        ++negated;
+      } else {
+        ++accepted;
+        ++negated;
+      }
+  }
+
+
+  std::uint32_t final_state(std::size_t i, std::string_view text) const noexcept {
+    automaton const& each = automata_[i];
+    return each.run(each.start, text, classes_);
+  }
+
+
+  // calls f(pattern_id) in ascending order of ids given final state of i-th
+  // automaton by final(i) and result of k-th fallback pattern by fallback(k)
+  template<typename S, typename M, typename F>
+  void report_all(S&& final, M&& fallback, F&& f) const {
+    std::size_t k = 0;
+    for(std::size_t i = 0; i != automata_.size(); ++i) {
+      for(; k != fallbacks_.size() && fallbacks_[k].id < automata_[i].first_id; ++k)
+        if(fallback(k))
+          f(std::size_t(fallbacks_[k].id));
+      report(automata_[i], final(i), f);
+    }
+    for(; k != fallbacks_.size(); ++k)
+      if(fallback(k))
+        f(std::size_t(fallbacks_[k].id));
+  }
+
+
+  // selected() given final state of i-th automaton by final(i) and result of
+  // k-th fallback pattern by fallback(k)
+  template<typename S, typename M>
+  bool decide(S&& final, M&& fallback) const {
+    bool included = includes_ == 0;
+    for(std::size_t i = 0; i != automata_.size(); ++i) {
+      state const& s = automata_[i].states[final(i)];
+      if(s.excluded)
+        return false;
+      included = included || s.included;
+    }
+    for(std::size_t k = 0; k != fallbacks_.size(); ++k) {
+      // '!' pattern is matched when its body is not
+      bool const matched = fallback(k);
+      if(negated_[fallbacks_[k].id]) {
+        if(!matched)
+          return false;
+      } else
+        included = included || matched;
+    }
+    return included;
+  }
+
+
+  void add(std::string_view pattern) {
+    compiled_pattern compiled{pattern};
+    std::uint32_t const id = std::uint32_t(negated_.size());
+    negated_.push_back(compiled.negated());
+    if(compiled.negated())
+      negated_ids_.push_back(id);
+    else
+      ++includes_;
+
+    starts_.push_back(std::uint32_t(positions_.size()));
+    for(std::size_t i = 0; i != compiled.atoms(); ++i)
+      switch(compiled.atom(i)) {
+        case compiled_pattern::literal_atom:
+          positions_.push_back(position{literal_position, compiled.symbol(i), id, 0});
+          continue;
+        case compiled_pattern::any_atom:
+          positions_.push_back(position{any_position, '?', id, 0});
+          continue;
+        case compiled_pattern::star_atom:
+          positions_.push_back(position{star_position, '*', id, 0});
+          continue;
+        default:
+          members_.push_back(compiled.atom_class(i));
+          positions_.push_back(position{class_position, '[', id,
+                                        std::uint32_t(members_.size() - 1)});
+          continue;
+      }
+    positions_.push_back(position{end_position, '\0', id, 0});
+    compiled_.push_back(std::move(compiled));
+  }
+
+
+  // splits every byte class in bytes which are members of set and the rest
+  template<typename M> static void refine(std::array<std::uint16_t, 256>& classes,
+                                          std::size_t& count, M&& member) {
+    std::vector<std::int32_t> renamed(count * 2, -1);
+    std::size_t next = 0;
+    for(unsigned c = 0; c != 256; ++c) {
+      std::size_t const key = classes[c] * 2 + (member(static_cast<char>(c)) ? 1 : 0);
+      if(renamed[key] < 0)
+        renamed[key] = std::int32_t(next++);
+      classes[c] = std::uint16_t(renamed[key]);
+    }
+    count = next;
+  }
+
+
+  void build(std::size_t max_states) {
+    // bytes no pattern tells apart share the same class
+    classes_.fill(0);
+    std::size_t count = 1;
+
+    std::array<bool, 256> used{};
+    for(position const& each: positions_)
+      if(each.type == literal_position)
+        used[static_cast<unsigned char>(each.symbol)] = true;
+
+    for(unsigned u = 0; u != 256; ++u)
+      if(used[u])
+        refine(classes_, count, [u](char c) { return static_cast<unsigned char>(c) == u; });
+
+    for(std::size_t i = 0; i != members_.size(); ++i)
+      if(i == 0 || members_[i] != members_[i - 1])
+        refine(classes_, count, [this, i](char c) { return members_[i].test(c); });
+
+    representatives_.assign(count, 0);
+    for(unsigned u = 256; u-- != 0; )
+      representatives_[classes_[u]] = static_cast<unsigned char>(u);
+
+    if(!negated_.empty())
+      build(0, std::uint32_t(negated_.size()), max_states);
+    std::vector<compiled_pattern>{}.swap(compiled_);
+  }
+
+
+  void build(std::uint32_t first, std::uint32_t last, std::size_t max_states) {
+    automaton a;
+    if(construct(first, last, max_states, a)) {
+      a.first_id = first;
+      a.first_negated = std::uint32_t(
+        std::lower_bound(negated_ids_.begin(), negated_ids_.end(), first) - negated_ids_.begin());
+      a.last_negated = std::uint32_t(
+        std::lower_bound(negated_ids_.begin(), negated_ids_.end(), last) - negated_ids_.begin());
+      automata_.push_back(std::move(a));
+      return;
+    }
+    // single pattern can not be split anymore
+    if(last - first == 1) {
+      fallbacks_.push_back(fallback{first, std::move(compiled_[first])});
+      return;
+    }
+    std::uint32_t const middle = first + (last - first) / 2;
+    build(first, middle, max_states);
+    build(middle, last, max_states);
+  }
+
+
+  void close(std::vector<std::uint32_t>& set) const {
+    std::size_t const n = set.size();
+    for(std::size_t i = 0; i != n; ++i)
+      for(std::uint32_t p = set[i]; positions_[p].type == star_position; )
+        set.push_back(++p);
+    std::sort(set.begin(), set.end());
+    set.erase(std::unique(set.begin(), set.end()), set.end());
+  }
+
+
+  // subset construction, false if more than max_states states required
+  bool construct(std::uint32_t first, std::uint32_t last,
+                 std::size_t max_states, automaton& a) {
+    std::size_t const first_accepted = accepted_.size();
+    a.class_count = representatives_.size();
+    a.states.assign(1, state{});
+    a.transitions.assign(a.class_count, 0);
+
+    std::map<std::vector<std::uint32_t>, std::uint32_t> known;
+    std::vector<std::vector<std::uint32_t>> sets;
+    known.emplace(std::vector<std::uint32_t>{}, 0);
+    sets.emplace_back();
+
+    auto intern = [&](std::vector<std::uint32_t> const& set) -> std::uint32_t {
+      auto const found = known.find(set);
+      if(found != known.end())
+        return found->second;
+      std::uint32_t const id = std::uint32_t(a.states.size());
+      state s;
+      s.first_accepted = std::uint32_t(accepted_.size());
+      for(std::uint32_t each: set)
+        if(positions_[each].type == end_position) {
+          std::uint32_t const pattern = positions_[each].pattern;
+          accepted_.push_back(pattern);
+          if(negated_[pattern])
+            s.excluded = true;
+          else
+            s.included = true;
+        }
+      s.accepted_count = std::uint32_t(accepted_.size()) - s.first_accepted;
+      a.states.push_back(s);
+      a.transitions.resize(a.transitions.size() + a.class_count, 0);
+      known.emplace(set, id);
+      sets.push_back(set);
+      return id;
+    };
+
+    std::vector<std::uint32_t> initial;
+    for(std::uint32_t i = first; i != last; ++i)
+      initial.push_back(starts_[i]);
+    close(initial);
+    a.start = intern(initial);
+
+    std::vector<std::uint32_t> next;
+    for(std::uint32_t current = 1; current != a.states.size(); ++current) {
+      if(a.states.size() > max_states) {
+        accepted_.resize(first_accepted);
+        return false;
+      }
+      for(std::size_t c = 0; c != a.class_count; ++c) {
+        char const symbol = static_cast<char>(representatives_[c]);
+        next.clear();
+        for(std::uint32_t each: sets[current]) {
+          position const& p = positions_[each];
+          switch(p.type) {
+            case star_position:
+              next.push_back(each);
+              continue;
+            case any_position:
+              next.push_back(each + 1);
+              continue;
+            case literal_position:
+              if(p.symbol == symbol)
+                next.push_back(each + 1);
+              continue;
+            case class_position:
+              if(members_[p.members].test(symbol))
+                next.push_back(each + 1);
+              continue;
+            case end_position:
+              continue;
+          }
+        }
+        close(next);
+        std::uint32_t const target = intern(next);
+        a.transitions[current * a.class_count + c] = target;
+      }
+    }
+
+    return true;
+  }
+
+}; // pattern_dfa
+
+
+} // chineseroom
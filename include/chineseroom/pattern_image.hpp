@@ -0,0 +1,620 @@
+/* This file is part of chineseroom library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "compiled_pattern.hpp"
+#include "pattern_index.hpp"
+#include "split.hpp"
+#include "wildcards.hpp"
+
+
+namespace chineseroom {
+
+
+namespace detail {
+
+  // FNV-1a, unlike std::hash it is the same for every build
+  inline std::uint64_t image_hash(std::string_view text) noexcept {
+    std::uint64_t h = 0xcbf29ce484222325ull;
+    for(char c: text) {
+      h ^= static_cast<unsigned char>(c);
+      h *= 0x100000001b3ull;
+    }
+    return h;
+  }
+
+
+  enum image_section : std::uint32_t {
+    image_patterns, image_strings, image_exact, image_unfiltered,
+    image_prefix_nodes, image_prefix_edges, image_prefix_ids,
+    image_suffix_nodes, image_suffix_edges, image_suffix_ids,
+    image_automaton_nodes, image_automaton_edges, image_automaton_ids,
+    image_automaton_root, image_section_count
+  };
+
+
+  struct image_header {
+    char magic[8];
+    std::uint32_t version;
+    // 0x01020304 as written by the machine the image was made on
+    std::uint32_t byte_order;
+    std::uint64_t size;
+    std::uint32_t includes;
+    std::uint32_t excludes;
+    // literals of automaton
+    std::uint32_t literals;
+    std::uint32_t sections;
+    struct {
+      std::uint64_t offset;
+      std::uint64_t size;
+    } table[image_section_count];
+  };
+
+
+  struct image_pattern {
+    // pattern as given, with '!'
+    std::uint32_t text_offset;
+    std::uint32_t text_size;
+    // literal the pattern is indexed by
+    std::uint32_t literal_offset;
+    std::uint32_t literal_size;
+    std::uint32_t negated;
+  };
+
+
+  struct image_slot {
+    std::uint64_t hash;
+    std::uint32_t id;
+    std::uint32_t unused;
+  };
+
+
+  // node of trie, ids of patterns are ones ending at the node
+  struct image_node {
+    std::uint32_t first_edge;
+    std::uint32_t edge_count;
+    std::uint32_t first_id;
+    std::uint32_t id_count;
+  };
+
+
+  // node of automaton
+  struct image_state {
+    std::uint32_t first_edge;
+    std::uint32_t edge_count;
+    std::uint32_t first_id;
+    std::uint32_t id_count;
+    std::uint32_t fail;
+    std::uint32_t dictionary;
+    // number of state among ones with ids
+    std::uint32_t literal;
+  };
+
+
+  struct image_edge {
+    std::uint32_t symbol;
+    std::uint32_t target;
+  };
+
+
+  inline constexpr char image_magic[8] = {'C', 'H', 'R', 'M', 'S', 'E', 'T', '\0'};
+  inline constexpr std::uint32_t image_none = std::uint32_t(-1);
+
+
+  // trie built in memory and flattened to image sections
+  class image_trie {
+  public:
+
+    image_trie() {
+      children_.emplace_back();
+      ids_.emplace_back();
+    }
+
+
+    template<typename K> void insert(K const& key, std::size_t size, std::uint32_t id) {
+      std::uint32_t state = 0;
+      for(std::size_t i = 0; i != size; ++i) {
+        std::uint32_t const symbol = key(i);
+        auto& edges = children_[state];
+        auto it = std::lower_bound(edges.begin(), edges.end(), symbol,
+          [](image_edge const& e, std::uint32_t s) { return e.symbol < s; });
+        if(it == edges.end() || it->symbol != symbol) {
+          std::uint32_t const next = std::uint32_t(children_.size());
+          edges.insert(it, image_edge{symbol, next});
+          children_.emplace_back();
+          ids_.emplace_back();
+          state = next;
+        } else
+          state = it->target;
+      }
+      ids_[state].push_back(id);
+    }
+
+
+    // fills nodes, edges and ids; returns number of nodes with ids
+    template<typename N>
+    std::uint32_t flatten(std::vector<N>& nodes, std::vector<image_edge>& edges,
+                          std::vector<std::uint32_t>& ids) const {
+      nodes.assign(children_.size(), N{});
+      edges.clear();
+      ids.clear();
+      std::uint32_t literals = 0;
+      for(std::uint32_t i = 0; i != children_.size(); ++i) {
+        N& n = nodes[i];
+        n.first_edge = std::uint32_t(edges.size());
+        n.edge_count = std::uint32_t(children_[i].size());
+        edges.insert(edges.end(), children_[i].begin(), children_[i].end());
+        n.first_id = std::uint32_t(ids.size());
+        n.id_count = std::uint32_t(ids_[i].size());
+        ids.insert(ids.end(), ids_[i].begin(), ids_[i].end());
+        if constexpr(std::is_same_v<N, image_state>)
+          n.literal = n.id_count != 0 ? literals : image_none;
+        literals += n.id_count != 0;
+      }
+      return literals;
+    }
+
+
+    // failure and dictionary links of automaton states
+    void link(std::vector<image_state>& states) const {
+      states[0].fail = 0;
+      states[0].dictionary = image_none;
+      // breadth first, so links of shorter states are known
+      std::vector<std::uint32_t> queue;
+      queue.reserve(states.size());
+      for(image_edge const& e: children_[0]) {
+        states[e.target].fail = 0;
+        states[e.target].dictionary = image_none;
+        queue.push_back(e.target);
+      }
+      for(std::size_t head = 0; head != queue.size(); ++head) {
+        std::uint32_t const state = queue[head];
+        for(image_edge const& e: children_[state]) {
+          std::uint32_t fail = states[state].fail;
+          std::uint32_t next = child(fail, e.symbol);
+          while(next == image_none && fail != 0) {
+            fail = states[fail].fail;
+            next = child(fail, e.symbol);
+          }
+          image_state& n = states[e.target];
+          n.fail = next == image_none ? 0 : next;
+          n.dictionary = states[n.fail].id_count != 0 ? n.fail : states[n.fail].dictionary;
+          queue.push_back(e.target);
+        }
+      }
+    }
+
+
+  private:
+
+    std::vector<std::vector<image_edge>> children_;
+    std::vector<std::vector<std::uint32_t>> ids_;
+
+
+    std::uint32_t child(std::uint32_t state, std::uint32_t symbol) const noexcept {
+      for(image_edge const& e: children_[state])
+        if(e.symbol == symbol)
+          return e.target;
+      return image_none;
+    }
+
+  }; // image_trie
+
+
+  template<typename T> void append_section(std::string& image, image_header& header,
+                                           image_section section, std::vector<T> const& items) {
+    // every section is aligned to 8 bytes
+    image.resize((image.size() + 7) & ~std::size_t(7));
+    header.table[section].offset = image.size();
+    header.table[section].size = items.size() * sizeof(T);
+    image.append(reinterpret_cast<char const*>(items.data()), items.size() * sizeof(T));
+  }
+
+
+  template<typename T> struct image_array {
+    T const* data{nullptr};
+    std::size_t size{0};
+
+    T const& operator [] (std::size_t i) const noexcept { return data[i]; }
+    bool empty() const noexcept { return size == 0; }
+  };
+
+} // detail
+
+
+// Pattern set written once to position independent bytes which are used
+// in place, e.g. mapped by mapped_file and shared by processes through
+// page cache, so nothing is compiled or allocated at start. Matching has
+// the meaning of pattern_set::matched_any: literal index, prefix and suffix
+// tries and Aho-Corasick automaton are stored flat with 32-bit links, and
+// candidates are verified by patterns as they were given.
+//
+// Image keeps numbers in byte order of the machine it was made on; open()
+// rejects images of other version or byte order. Image is trusted: only
+// the header and bounds of sections are checked.
+class pattern_image {
+public:
+
+  static constexpr std::uint32_t version = 1;
+
+
+  // throws std::length_error if texts of patterns don't fit 32-bit offsets
+  static std::string make(std::vector<std::string> const& patterns) {
+    using namespace detail;
+    image_header header{};
+    std::copy_n(image_magic, 8, header.magic);
+    header.version = version;
+    header.byte_order = 0x01020304;
+    header.sections = image_section_count;
+
+    std::vector<image_pattern> entries;
+    std::string strings;
+    std::vector<std::uint32_t> unfiltered;
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> exact;
+    image_trie prefixes, suffixes, automaton;
+
+    for(std::string const& each: patterns) {
+      compiled_pattern const p{each};
+      std::uint32_t const id = std::uint32_t(entries.size());
+      pattern_place const place = place_of(p);
+      std::string_view const literal = indexed_literal(p, place);
+
+      // literal of a pattern without wildcards is mostly the pattern itself
+      bool const shared = literal == each;
+      std::size_t const added = each.size() + (shared ? 0 : literal.size());
+      if(added > std::size_t(image_none) - strings.size())
+        throw std::length_error{"chineseroom::pattern_image: texts of patterns exceed 4 GiB"};
+
+      image_pattern entry{};
+      entry.text_offset = std::uint32_t(strings.size());
+      entry.text_size = std::uint32_t(each.size());
+      strings += each;
+      entry.literal_offset = entry.text_offset;
+      entry.literal_size = std::uint32_t(literal.size());
+      if(!shared) {
+        entry.literal_offset = std::uint32_t(strings.size());
+        strings += literal;
+      }
+      entry.negated = p.negated();
+      entries.push_back(entry);
+      ++(p.negated() ? header.excludes : header.includes);
+
+      auto const forward = [literal](std::size_t i) {
+        return std::uint32_t(static_cast<unsigned char>(literal[i]));
+      };
+      auto const backward = [literal](std::size_t i) {
+        return std::uint32_t(static_cast<unsigned char>(literal[literal.size() - 1 - i]));
+      };
+      switch(place) {
+        case pattern_place::exact:
+          exact.emplace_back(image_hash(literal), id);
+          break;
+        case pattern_place::unfiltered:
+          unfiltered.push_back(id);
+          break;
+        case pattern_place::prefix:
+          prefixes.insert(forward, literal.size(), id);
+          break;
+        case pattern_place::suffix:
+          suffixes.insert(backward, literal.size(), id);
+          break;
+        case pattern_place::automaton:
+          automaton.insert(forward, literal.size(), id);
+          break;
+      }
+    }
+
+    // open addressing by hash with at most 3/4 of slots used
+    std::size_t capacity = exact.empty() ? 0 : 16;
+    while(capacity * 3 < exact.size() * 4)
+      capacity *= 2;
+    std::vector<image_slot> slots(capacity, image_slot{0, image_none, 0});
+    for(auto const& [hash, id]: exact) {
+      std::size_t i = std::size_t(hash) & (capacity - 1);
+      while(slots[i].id != image_none)
+        i = (i + 1) & (capacity - 1);
+      slots[i] = image_slot{hash, id, 0};
+    }
+
+    std::vector<image_node> nodes;
+    std::vector<image_state> states;
+    std::vector<image_edge> edges;
+    std::vector<std::uint32_t> ids;
+    std::string image(sizeof(image_header), '\0');
+    append_section(image, header, image_patterns, entries);
+    append_section(image, header, image_strings, std::vector<char>{strings.begin(), strings.end()});
+    append_section(image, header, image_exact, slots);
+    append_section(image, header, image_unfiltered, unfiltered);
+    prefixes.flatten(nodes, edges, ids);
+    append_section(image, header, image_prefix_nodes, nodes);
+    append_section(image, header, image_prefix_edges, edges);
+    append_section(image, header, image_prefix_ids, ids);
+    suffixes.flatten(nodes, edges, ids);
+    append_section(image, header, image_suffix_nodes, nodes);
+    append_section(image, header, image_suffix_edges, edges);
+    append_section(image, header, image_suffix_ids, ids);
+    header.literals = automaton.flatten(states, edges, ids);
+    automaton.link(states);
+    append_section(image, header, image_automaton_nodes, states);
+    append_section(image, header, image_automaton_edges, edges);
+    append_section(image, header, image_automaton_ids, ids);
+    // transitions of the root state by every byte
+    std::vector<std::uint32_t> root(256, 0);
+    for(std::uint32_t e = 0; e != states[0].edge_count; ++e)
+      root[edges[e].symbol] = edges[e].target;
+    append_section(image, header, image_automaton_root, root);
+
+    header.size = image.size();
+    std::memcpy(&image[0], &header, sizeof(header));
+    return image;
+  }
+
+
+  // comma separated list of patterns
+  static std::string make(std::string const& patterns) {
+    return make(split(patterns, ','));
+  }
+
+
+  pattern_image() = default;
+
+
+  // bytes have to be aligned to 8 and outlive the image
+  explicit pattern_image(std::string_view bytes) noexcept {
+    open(bytes);
+  }
+
+
+  // returns false if bytes are not an image of this version
+  bool open(std::string_view bytes) noexcept {
+    using namespace detail;
+    *this = pattern_image{};
+    if(bytes.size() < sizeof(image_header)
+       || reinterpret_cast<std::uintptr_t>(bytes.data()) % 8 != 0)
+      return false;
+    image_header header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if(std::memcmp(header.magic, image_magic, 8) != 0 || header.version != version
+       || header.byte_order != 0x01020304 || header.sections != image_section_count
+       || header.size != bytes.size())
+      return false;
+    for(auto const& section: header.table)
+      if(section.offset % 8 != 0 || section.offset > bytes.size()
+         || section.size > bytes.size() - section.offset)
+        return false;
+
+    bool sized = true;
+    auto const array = [&](auto& to, image_section section) {
+      using T = std::remove_reference_t<decltype(*to.data)>;
+      to.data = reinterpret_cast<T const*>(bytes.data() + header.table[section].offset);
+      to.size = std::size_t(header.table[section].size / sizeof(T));
+      sized = sized && header.table[section].size % sizeof(T) == 0;
+    };
+    array(patterns_, image_patterns);
+    array(strings_, image_strings);
+    array(exact_, image_exact);
+    array(unfiltered_, image_unfiltered);
+    array(prefixes_.nodes, image_prefix_nodes);
+    array(prefixes_.edges, image_prefix_edges);
+    array(prefixes_.ids, image_prefix_ids);
+    array(suffixes_.nodes, image_suffix_nodes);
+    array(suffixes_.edges, image_suffix_edges);
+    array(suffixes_.ids, image_suffix_ids);
+    array(automaton_.nodes, image_automaton_nodes);
+    array(automaton_.edges, image_automaton_edges);
+    array(automaton_.ids, image_automaton_ids);
+    array(root_, image_automaton_root);
+    if(!sized || root_.size != 256 || prefixes_.nodes.empty() || suffixes_.nodes.empty()
+       || automaton_.nodes.empty() || (exact_.size & (exact_.size - 1)) != 0) {
+      *this = pattern_image{};
+      return false;
+    }
+
+    includes_ = header.includes;
+    excludes_ = header.excludes;
+    literals_ = header.literals;
+    return true;
+  }
+
+
+  bool is_open() const noexcept { return !root_.empty(); }
+  std::size_t size() const noexcept { return patterns_.size; }
+  bool empty() const noexcept { return patterns_.size == 0; }
+
+
+  // pattern as it was given
+  std::string_view operator [] (std::size_t id) const noexcept {
+    return text(patterns_[id]);
+  }
+
+
+  bool matched_any(std::string_view text) const {
+    bool included = includes_ == 0;
+    bool rejected = false;
+
+    if(included && excludes_ == 0)
+      return true;
+
+    // include patterns need no verification once one of them matched
+    auto const wanted = [&](std::uint32_t each) {
+      return !included || patterns_[each].negated != 0;
+    };
+
+    matched(text, wanted, [&](std::uint32_t each) {
+      if(patterns_[each].negated != 0)
+        rejected = true;
+      else
+        included = true;
+      return !rejected && !(included && excludes_ == 0);
+    });
+
+    return included && !rejected;
+  }
+
+
+  // calls f(id) for every pattern whose body matches the text and for which
+  // wanted(id) is true like pattern_index::matched
+  template<typename W, typename F>
+  bool matched(std::string_view text, W&& wanted, F&& f) const {
+    using namespace detail;
+    if(!exact_.empty()) {
+      std::uint64_t const h = image_hash(text);
+      std::size_t const mask = exact_.size - 1;
+      for(std::size_t i = std::size_t(h) & mask; exact_[i].id != image_none; i = (i + 1) & mask) {
+        std::uint32_t const id = exact_[i].id;
+        if(exact_[i].hash == h && literal(patterns_[id]) == text && wanted(id) && !f(id))
+          return false;
+      }
+    }
+
+    auto const verify = [&](std::uint32_t each) {
+      if(!wanted(each))
+        return true;
+      image_pattern const& p = patterns_[each];
+      if(detail::matched(strings_.data + p.text_offset, p.text_size,
+                         text.data(), text.size()) == (p.negated != 0))
+        return true;
+      return f(each);
+    };
+
+    for(std::size_t i = 0; i != unfiltered_.size; ++i)
+      if(!verify(unfiltered_[i]))
+        return false;
+
+    auto const forward = [text](std::size_t i) { return static_cast<unsigned char>(text[i]); };
+    auto const backward = [text](std::size_t i) {
+      return static_cast<unsigned char>(text[text.size() - 1 - i]);
+    };
+    if(!prefixes_.walk(forward, text.size(), verify)
+       || !suffixes_.walk(backward, text.size(), verify))
+      return false;
+
+    if(automaton_.ids.empty())
+      return true;
+
+    literal_marks marks{literals_};
+    std::uint32_t state = 0;
+    for(std::size_t i = 0; i != text.size(); ++i) {
+      state = next_state(state, static_cast<unsigned char>(text[i]));
+      if(state == 0)
+        continue;
+      image_state const& last = automaton_.nodes[state];
+      std::uint32_t found = last.id_count != 0 ? state : last.dictionary;
+      for(; found != image_none; found = automaton_.nodes[found].dictionary) {
+        image_state const& n = automaton_.nodes[found];
+        if(!marks.mark(n.literal))
+          continue;
+        for(std::uint32_t k = 0; k != n.id_count; ++k)
+          if(!verify(automaton_.ids[n.first_id + k]))
+            return false;
+      }
+    }
+    return true;
+  }
+
+
+private:
+
+  // trie or automaton stored flat
+  template<typename N> struct flat_trie {
+    detail::image_array<N> nodes;
+    detail::image_array<detail::image_edge> edges;
+    detail::image_array<std::uint32_t> ids;
+
+    std::uint32_t child(std::uint32_t state, std::uint32_t symbol) const noexcept {
+      N const& n = nodes[state];
+      detail::image_edge const* const first = edges.data + n.first_edge;
+      detail::image_edge const* const last = first + n.edge_count;
+      detail::image_edge const* const it = std::lower_bound(first, last, symbol,
+        [](detail::image_edge const& e, std::uint32_t s) { return e.symbol < s; });
+      return it != last && it->symbol == symbol ? it->target : detail::image_none;
+    }
+
+    // calls f(id) for ids of every literal the key starts with
+    template<typename K, typename F>
+    bool walk(K const& key, std::size_t size, F const& f) const {
+      std::uint32_t state = 0;
+      for(std::size_t i = 0; ; ++i) {
+        N const& n = nodes[state];
+        for(std::uint32_t k = 0; k != n.id_count; ++k)
+          if(!f(ids[n.first_id + k]))
+            return false;
+        if(i == size)
+          return true;
+        state = child(state, key(i));
+        if(state == detail::image_none)
+          return true;
+      }
+    }
+  };
+
+  detail::image_array<detail::image_pattern> patterns_;
+  detail::image_array<char> strings_;
+  detail::image_array<detail::image_slot> exact_;
+  detail::image_array<std::uint32_t> unfiltered_;
+  flat_trie<detail::image_node> prefixes_;
+  flat_trie<detail::image_node> suffixes_;
+  flat_trie<detail::image_state> automaton_;
+  // transitions of the root of automaton by every byte
+  detail::image_array<std::uint32_t> root_;
+  std::size_t includes_{0};
+  std::size_t excludes_{0};
+  std::size_t literals_{0};
+
+
+  std::string_view text(detail::image_pattern const& p) const noexcept {
+    return std::string_view{strings_.data + p.text_offset, p.text_size};
+  }
+
+
+  std::string_view literal(detail::image_pattern const& p) const noexcept {
+    return std::string_view{strings_.data + p.literal_offset, p.literal_size};
+  }
+
+
+  std::uint32_t next_state(std::uint32_t state, unsigned char symbol) const noexcept {
+    for(;;) {
+      if(state == 0)
+        return root_[symbol];
+      std::uint32_t const next = automaton_.child(state, symbol);
+      if(next != detail::image_none)
+        return next;
+      state = automaton_.nodes[state].fail;
+    }
+  }
+
+}; // pattern_image
+
+
+} // chineseroom
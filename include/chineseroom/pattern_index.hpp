@@ -0,0 +1,780 @@
+/* This file is part of chineseroom library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "aho_corasick.hpp"
+#include "compiled_pattern.hpp"
+#include "literal_index.hpp"
+#include "literal_trie.hpp"
+#include "parallel.hpp"
+#include "text_signature.hpp"
+
+
+namespace chineseroom {
+
+
+// approximate bytes taken by a pattern index
+struct memory_usage {
+  // texts of patterns without wildcards
+  std::size_t texts{0};
+  // compiled patterns and records of every pattern
+  std::size_t patterns{0};
+  // hash of literals, tries and automata
+  std::size_t indexes{0};
+
+  std::size_t total() const noexcept { return texts + patterns + indexes; }
+};
+
+
+namespace detail {
+
+  // per thread marks of literals already seen during one scan, so each
+  // candidate pattern is verified once however often its literal occurs.
+  // A scan started from a callback of another scan on the same thread takes
+  // marks of its own, the outer ones are kept.
+  class literal_marks {
+  public:
+
+    explicit literal_marks(std::size_t literals): marks_{acquire()} {
+      marks_.start(literals);
+    }
+
+    literal_marks(literal_marks const&) = delete;
+    literal_marks& operator = (literal_marks const&) = delete;
+
+    ~literal_marks() { --local().depth; }
+
+    // true the first time literal is marked during current scan
+    bool mark(std::uint32_t literal) noexcept {
+      if(marks_.marks[literal] == marks_.epoch)
+        return false;
+      marks_.marks[literal] = marks_.epoch;
+      return true;
+    }
+
+  private:
+
+    struct buffer {
+      std::vector<std::uint32_t> marks;
+      std::uint32_t epoch{0};
+
+      void start(std::size_t literals) {
+        if(marks.size() < literals)
+          marks.resize(literals, 0);
+        if(++epoch == 0) {
+          std::fill(marks.begin(), marks.end(), 0);
+          epoch = 1;
+        }
+      }
+    };
+
+    // buffers by depth of nested scans, deque keeps them in place
+    struct buffers {
+      std::deque<buffer> nested;
+      std::size_t depth{0};
+    };
+
+    buffer& marks_;
+
+    static buffers& local() {
+      thread_local buffers each;
+      return each;
+    }
+
+    static buffer& acquire() {
+      buffers& each = local();
+      if(each.depth == each.nested.size())
+        each.nested.emplace_back();
+      return each.nested[each.depth++];
+    }
+  };
+
+
+  // where pattern is indexed: by hash of its text, in no index, by its
+  // head, by its tail or by its longest literal
+  enum class pattern_place : std::uint8_t {
+    exact, unfiltered, prefix, suffix, automaton
+  };
+
+
+  inline pattern_place place_of(compiled_pattern const& p) noexcept {
+    if(p.literal())
+      return pattern_place::exact;
+
+    std::string_view const head = p.head();
+    std::string_view const tail = p.tail();
+    std::string_view const literal = p.longest_literal();
+
+    if(literal.empty())
+      return pattern_place::unfiltered;
+    if(head.size() >= tail.size() && head.size() >= literal.size())
+      return pattern_place::prefix;
+    if(tail.size() >= literal.size())
+      return pattern_place::suffix;
+    return pattern_place::automaton;
+  }
+
+
+  // literal pattern is indexed by
+  inline std::string_view indexed_literal(compiled_pattern const& p, pattern_place place) noexcept {
+    switch(place) {
+      case pattern_place::exact:
+      case pattern_place::prefix:
+        return p.head();
+      case pattern_place::suffix:
+        return p.tail();
+      case pattern_place::automaton:
+        return p.longest_literal();
+      default:
+        return std::string_view{};
+    }
+  }
+
+} // detail
+
+
+// Compiled patterns indexed by literals they require, so matching a text
+// verifies only candidates: patterns without wildcards are found by hash,
+// patterns by the longest of their head, tail and longest literal in prefix
+// trie, suffix trie or Aho-Corasick automaton; patterns without literals are
+// always verified. Negation of patterns is left to the owner: only bodies
+// are matched.
+//
+// Patterns may be inserted and removed one by one. Hash of literals and tries
+// are patched in place. Automata are kept in levels merged like a binary
+// counter, so inserting a pattern rebuilds O(log n) literals amortized and a
+// text is scanned by O(log n) automata at most.
+//
+// Only patterns which have to be verified are kept compiled. Text of the
+// rest, patterns without wildcards and 'head*' or '*tail' ones matched once
+// they are found, is kept in one arena with 32-bit offsets; equal texts of
+// patterns without wildcards are stored once.
+class pattern_index {
+public:
+
+  pattern_index() = default;
+
+
+  // number of patterns, ids of removed ones are reused
+  std::size_t size() const noexcept { return entries_.size() - free_ids_.size(); }
+  bool empty() const noexcept { return size() == 0; }
+
+  // pattern by value, compiled again with allocations on every call if it is
+  // kept as text; body(), negated() and literal() don't compile anything
+  compiled_pattern operator [] (std::size_t id) const {
+    entry const& e = entries_[id];
+    if(e.compiled != none)
+      return compiled_[e.compiled];
+    std::string pattern = e.negated ? "!" : "";
+    pattern += body(id);
+    return compiled_pattern{pattern};
+  }
+
+  bool contains(std::size_t id) const noexcept {
+    return id < entries_.size() && entries_[id].live;
+  }
+
+  bool negated(std::size_t id) const noexcept { return entries_[id].negated; }
+
+  // pattern without wildcards
+  bool literal(std::size_t id) const noexcept {
+    return entries_[id].where == place::exact;
+  }
+
+  // pattern without leading '!'
+  std::string_view body(std::size_t id) const noexcept {
+    entry const& e = entries_[id];
+    if(e.compiled != none)
+      return compiled_[e.compiled].body();
+    return std::string_view{texts_.data() + e.offset, e.size};
+  }
+
+  bool matched_body(std::size_t id, std::string_view text) const noexcept {
+    entry const& e = entries_[id];
+    if(e.compiled != none)
+      return compiled_[e.compiled].matched_body(text);
+    std::string_view const literal = indexed_literal(std::uint32_t(id));
+    switch(e.where) {
+      case place::prefix:
+        return text.substr(0, literal.size()) == literal;
+      case place::suffix:
+        return text.size() >= literal.size()
+            && text.substr(text.size() - literal.size()) == literal;
+      default:
+        return text == literal;
+    }
+  }
+
+
+  // approximate bytes taken by the index
+  memory_usage memory() const noexcept {
+    memory_usage usage;
+    usage.texts = texts_.capacity();
+    usage.patterns = entries_.capacity() * sizeof(entry)
+                   + compiled_.capacity() * sizeof(compiled_pattern)
+                   + free_ids_.capacity() * sizeof(std::uint32_t)
+                   + free_compiled_.capacity() * sizeof(std::uint32_t);
+    for(compiled_pattern const& each: compiled_)
+      usage.patterns += each.allocated();
+    usage.indexes = exact_.allocated() + prefixes_.allocated() + suffixes_.allocated()
+                  + unfiltered_.capacity() * sizeof(std::uint32_t)
+                  + levels_.capacity() * sizeof(literal_level);
+    for(literal_level const& level: levels_) {
+      usage.indexes += level.automaton.allocated()
+                     + level.literals.capacity() * sizeof(std::string)
+                     + level.patterns.capacity() * sizeof(std::vector<std::uint32_t>);
+      for(std::string const& each: level.literals)
+        usage.indexes += detail::allocated(each);
+      for(auto const& ids: level.patterns)
+        usage.indexes += ids.capacity() * sizeof(std::uint32_t);
+    }
+    return usage;
+  }
+
+
+  // adds pattern without building automata, build() has to follow; throws
+  // std::length_error leaving the index as is when texts would exceed 4 GiB
+  std::uint32_t add(std::string_view pattern) {
+    compiled_pattern p{pattern};
+    place const where = detail::place_of(p);
+    bool const kept_as_text = plain(p, where);
+    if(kept_as_text)
+      check_texts(p.body().size());
+
+    std::uint32_t id = std::uint32_t(entries_.size());
+    if(free_ids_.empty())
+      entries_.emplace_back();
+    else {
+      id = free_ids_.back();
+      free_ids_.pop_back();
+    }
+    entry& e = entries_[id];
+    e = entry{0, 0, none, where, p.negated(), true};
+
+    if(kept_as_text)
+      store_text(id, p.body());
+
+    switch(e.where) {
+      case place::exact:
+        exact_.insert(p.head(), id);
+        break;
+      case place::unfiltered:
+        unfiltered_.push_back(id);
+        break;
+      case place::prefix:
+        prefixes_.insert(p.head(), id);
+        break;
+      case place::suffix:
+        suffixes_.insert(p.tail(), id);
+        break;
+      case place::automaton:
+        add_literal(p.longest_literal(), id);
+        break;
+    }
+
+    if(!kept_as_text) {
+      std::uint32_t c = std::uint32_t(compiled_.size());
+      if(free_compiled_.empty())
+        compiled_.push_back(std::move(p));
+      else {
+        c = free_compiled_.back();
+        free_compiled_.pop_back();
+        compiled_[c] = std::move(p);
+      }
+      entries_[id].compiled = c;
+    }
+    return id;
+  }
+
+
+  void build() {
+    for(literal_level& level: levels_)
+      level.automaton.build();
+  }
+
+
+  // adds patterns with consecutive ids and builds automata, 0 threads to use
+  // every hardware thread. Patterns are compiled and classified by threads in
+  // chunks, then every index is filled by its own thread in order of ids, so
+  // the index is the same for any number of threads. An index not empty takes
+  // patterns one by one. Throws std::length_error leaving the index empty when
+  // texts, counted without sharing, would exceed 4 GiB.
+  template<typename R> void add_all(R const& patterns, unsigned threads = 0) {
+    std::size_t const count = std::size(patterns);
+    auto const pattern = [&](std::size_t i) {
+      return std::string_view{*(std::begin(patterns) + i)};
+    };
+    if(!entries_.empty()) {
+      for(std::size_t i = 0; i != count; ++i)
+        add(pattern(i));
+      build();
+      return;
+    }
+
+    // only patterns to verify are kept compiled, by chunks with indexes in
+    // them; literals of the rest are cut from the patterns themselves
+    std::size_t const chunks = (count + compile_chunk - 1) / compile_chunk;
+    std::vector<std::vector<compiled_pattern>> compiled(chunks);
+    std::vector<std::size_t> chunk_texts(chunks, 0);
+    std::vector<entry> entries(count);
+    detail::run_chunks(chunks, threads, [&](std::size_t chunk) {
+      std::size_t const last = std::min(count, (chunk + 1) * compile_chunk);
+      for(std::size_t i = chunk * compile_chunk; i != last; ++i) {
+        compiled_pattern p{pattern(i)};
+        place const where = detail::place_of(p);
+        entry& e = entries[i];
+        e = entry{0, 0, none, where, p.negated(), true};
+        if(plain(p, where))
+          chunk_texts[chunk] += p.body().size();
+        else {
+          e.compiled = std::uint32_t(compiled[chunk].size());
+          compiled[chunk].push_back(std::move(p));
+        }
+      }
+    });
+
+    std::size_t texts = 0;
+    for(std::size_t each: chunk_texts)
+      texts += each;
+    check_texts(texts);
+
+    auto const body = [&](std::uint32_t id) {
+      return pattern(id).substr(entries[id].negated ? 1 : 0);
+    };
+    auto const literal = [&](std::uint32_t id) {
+      entry const& e = entries[id];
+      if(e.compiled != none)
+        return detail::indexed_literal(compiled[id / compile_chunk][e.compiled], e.where);
+      return plain_literal(body(id), e.where);
+    };
+
+    // every task fills one index in order of ids
+    enum task { exact, unfiltered, prefixes, suffixes, automaton, tasks };
+    detail::run_chunks(tasks, threads, [&](std::size_t t) {
+      for(std::uint32_t id = 0; id != count; ++id) {
+        place const where = entries[id].where;
+        switch(t) {
+          case exact:
+            if(where == place::exact)
+              exact_.insert(literal(id), id);
+            break;
+          case unfiltered:
+            if(where == place::unfiltered)
+              unfiltered_.push_back(id);
+            break;
+          case prefixes:
+            if(where == place::prefix)
+              prefixes_.insert(literal(id), id);
+            break;
+          case suffixes:
+            if(where == place::suffix)
+              suffixes_.insert(literal(id), id);
+            break;
+          case automaton:
+            if(where == place::automaton)
+              add_literal(literal(id), id);
+            break;
+        }
+      }
+      // texts are shared by the hash of literals filled already
+      if(t == exact)
+        store_texts(entries, body, literal);
+      else if(t == automaton)
+        build();
+    });
+
+    // chunks are joined in order, indexes in them become indexes in compiled_
+    std::size_t kept = 0;
+    for(auto const& each: compiled)
+      kept += each.size();
+    compiled_.reserve(kept);
+    for(std::size_t chunk = 0; chunk != chunks; ++chunk) {
+      std::size_t const last = std::min(count, (chunk + 1) * compile_chunk);
+      for(std::size_t id = chunk * compile_chunk; id != last; ++id) {
+        entry& e = entries[id];
+        if(e.compiled == none)
+          continue;
+        std::uint32_t const c = std::uint32_t(compiled_.size());
+        compiled_.push_back(std::move(compiled[chunk][e.compiled]));
+        e.compiled = c;
+      }
+      std::vector<compiled_pattern>{}.swap(compiled[chunk]);
+    }
+    entries_ = std::move(entries);
+  }
+
+
+  // adds pattern patching indexes, returns its id
+  std::uint32_t insert(std::string_view pattern) {
+    std::uint32_t const id = add(pattern);
+    if(entries_[id].where == place::automaton)
+      merge_levels();
+    return id;
+  }
+
+
+  bool remove(std::uint32_t id) {
+    if(!contains(id))
+      return false;
+    entry& e = entries_[id];
+    std::string_view const indexed = indexed_literal(id);
+
+    switch(e.where) {
+      case place::exact:
+        exact_.erase(indexed, id);
+        break;
+      case place::unfiltered:
+        unfiltered_.erase(std::find(unfiltered_.begin(), unfiltered_.end(), id));
+        break;
+      case place::prefix:
+        prefixes_.erase(indexed, id);
+        break;
+      case place::suffix:
+        suffixes_.erase(indexed, id);
+        break;
+      case place::automaton:
+        for(literal_level& level: levels_) {
+          std::uint32_t const literal = level.automaton.find(indexed);
+          if(literal == aho_corasick::none)
+            continue;
+          auto& ids = level.patterns[literal];
+          auto const it = std::find(ids.begin(), ids.end(), id);
+          if(it != ids.end()) {
+            ids.erase(it);
+            break;
+          }
+        }
+        break;
+    }
+
+    if(e.compiled != none) {
+      compiled_[e.compiled] = compiled_pattern{};
+      free_compiled_.push_back(e.compiled);
+    } else
+      release_text(id);
+    e = entry{0, 0, none, place::exact, false, false};
+    free_ids_.push_back(id);
+    return true;
+  }
+
+
+  // calls f(id) for every pattern whose body matches the text and for which
+  // wanted(id) is true, stops when f returns false; returns false if it was
+  // stopped. Patterns without wildcards are visited first.
+  template<typename W, typename F>
+  bool matched(std::string_view text, W&& wanted, F&& f) const {
+    auto const literal = [this](std::uint32_t id) { return indexed_literal(id); };
+    auto const found = [&](std::uint32_t each) {
+      return !wanted(each) || f(each);
+    };
+    if(!exact_.find(text, literal, found))
+      return false;
+
+    // signature is computed for the first candidate only
+    text_signature signature;
+    bool signed_text = false;
+    auto const verify = [&](std::uint32_t each) {
+      if(!wanted(each))
+        return true;
+      std::uint32_t const c = entries_[each].compiled;
+      // pattern kept as text is matched once it is found by the literal
+      if(c == none)
+        return f(each);
+      if(!signed_text) {
+        signature = text_signature{text};
+        signed_text = true;
+      }
+      if(!compiled_[c].matched_body(text, signature))
+        return true;
+      return f(each);
+    };
+
+    for(std::uint32_t each: unfiltered_)
+      if(!verify(each))
+        return false;
+
+    if(!prefixes_.walk(text, verify) || !suffixes_.walk(text, verify))
+      return false;
+
+    std::size_t literals = 0;
+    for(literal_level const& level: levels_)
+      literals += level.literals.size();
+
+    detail::literal_marks marks{literals};
+
+    std::uint32_t base = 0;
+    for(literal_level const& level: levels_) {
+      bool const going = level.automaton.scan(text, [&](std::uint32_t literal, std::size_t) {
+        if(!marks.mark(base + literal))
+          return true;
+        for(std::uint32_t each: level.patterns[literal])
+          if(!verify(each))
+            return false;
+        return true;
+      });
+      if(!going)
+        return false;
+      base += std::uint32_t(level.literals.size());
+    }
+
+    return true;
+  }
+
+
+private:
+
+  using place = detail::pattern_place;
+
+  // automaton of longest literals of some patterns
+  struct literal_level {
+    aho_corasick automaton;
+    std::vector<std::string> literals;
+    // patterns by id of their longest literal
+    std::vector<std::vector<std::uint32_t>> patterns;
+
+    void add(std::string_view literal, std::uint32_t id) {
+      std::uint32_t const literal_id = automaton.add(literal);
+      if(literal_id == literals.size()) {
+        literals.emplace_back(literal);
+        patterns.emplace_back();
+      }
+      patterns[literal_id].push_back(id);
+    }
+  };
+
+  static constexpr std::uint32_t none = std::uint32_t(-1);
+  // patterns compiled by a thread at once by add_all()
+  static constexpr std::size_t compile_chunk = 4096;
+
+  struct entry {
+    // text of pattern without wildcards in texts_
+    std::uint32_t offset;
+    std::uint32_t size;
+    // index of compiled pattern or none
+    std::uint32_t compiled;
+    place where;
+    bool negated;
+    bool live;
+  };
+
+  std::vector<entry> entries_;
+  std::vector<std::uint32_t> free_ids_;
+  std::vector<compiled_pattern> compiled_;
+  std::vector<std::uint32_t> free_compiled_;
+  // texts of patterns without wildcards
+  std::string texts_;
+  // bytes of texts no longer used by any pattern
+  std::size_t unused_texts_{0};
+  // patterns without wildcards
+  literal_index exact_;
+  prefix_trie prefixes_;
+  suffix_trie suffixes_;
+  // the first level is the largest one
+  std::vector<literal_level> levels_;
+  // patterns without any literal to search for
+  std::vector<std::uint32_t> unfiltered_;
+
+
+  // pattern without wildcards or with only the last (first) star after
+  // (before) its literal is matched by the literal alone
+  static bool plain(compiled_pattern const& p, place where) noexcept {
+    std::string_view const body = p.body();
+    switch(where) {
+      case place::exact:
+        return body == p.head();
+      case place::prefix:
+        return body.size() == p.head().size() + 1 && body.back() == '*'
+            && body.substr(0, body.size() - 1) == p.head();
+      case place::suffix:
+        return body.size() == p.tail().size() + 1 && body.front() == '*'
+            && body.substr(1) == p.tail();
+      default:
+        return false;
+    }
+  }
+
+
+  // literal the pattern is found by
+  std::string_view indexed_literal(std::uint32_t id) const noexcept {
+    entry const& e = entries_[id];
+    if(e.compiled != none)
+      return detail::indexed_literal(compiled_[e.compiled], e.where);
+    return plain_literal(std::string_view{texts_.data() + e.offset, e.size}, e.where);
+  }
+
+
+  // literal of the body of pattern kept as text
+  static std::string_view plain_literal(std::string_view body, place where) noexcept {
+    switch(where) {
+      case place::prefix:
+        return body.substr(0, body.size() - 1);
+      case place::suffix:
+        return body.substr(1);
+      default:
+        return body;
+    }
+  }
+
+
+  // offset of the same text of another pattern without wildcards or none
+  std::uint32_t shared_text(std::uint32_t id, std::string_view text) const {
+    std::uint32_t offset = none;
+    if(entries_[id].where != place::exact)
+      return offset;
+    auto const literal = [this](std::uint32_t each) { return indexed_literal(each); };
+    exact_.find(text, literal, [&](std::uint32_t each) {
+      if(each == id || entries_[each].compiled != none)
+        return true;
+      offset = entries_[each].offset;
+      return false;
+    });
+    return offset;
+  }
+
+
+  // 32-bit offsets limit texts by 4 GiB
+  void check_texts(std::size_t added) const {
+    if(added > std::size_t(none) - texts_.size())
+      throw std::length_error{"chineseroom::pattern_index: texts of patterns exceed 4 GiB"};
+  }
+
+
+  void store_text(std::uint32_t id, std::string_view text) {
+    std::uint32_t offset = shared_text(id, text);
+    if(offset == none) {
+      offset = std::uint32_t(texts_.size());
+      texts_ += text;
+    }
+    entries_[id].offset = offset;
+    entries_[id].size = std::uint32_t(text.size());
+  }
+
+
+  // texts stored by add_all() in order of ids as store_text() stores them,
+  // only offsets of entries are written
+  template<typename B, typename L>
+  void store_texts(std::vector<entry>& entries, B const& body, L const& literal) {
+    for(std::uint32_t id = 0; id != entries.size(); ++id) {
+      entry& e = entries[id];
+      if(e.compiled != none)
+        continue;
+      std::string_view const text = body(id);
+      std::uint32_t offset = none;
+      if(e.where == place::exact)
+        exact_.find(text, literal, [&](std::uint32_t each) {
+          if(each >= id || entries[each].compiled != none)
+            return true;
+          offset = entries[each].offset;
+          return false;
+        });
+      if(offset == none) {
+        offset = std::uint32_t(texts_.size());
+        texts_ += text;
+      }
+      e.offset = offset;
+      e.size = std::uint32_t(text.size());
+    }
+  }
+
+
+  // frees text of the pattern removed from indexes, the arena is compacted
+  // when most of it is unused
+  void release_text(std::uint32_t id) {
+    entry const& e = entries_[id];
+    if(shared_text(id, std::string_view{texts_.data() + e.offset, e.size}) != none)
+      return;
+    unused_texts_ += e.size;
+    if(unused_texts_ < 4096 || unused_texts_ * 2 < texts_.size())
+      return;
+
+    std::string compacted;
+    compacted.reserve(texts_.size() - unused_texts_);
+    std::unordered_map<std::uint32_t, std::uint32_t> moved;
+    for(std::uint32_t each = 0; each != entries_.size(); ++each) {
+      entry& other = entries_[each];
+      if(!other.live || other.compiled != none || each == id)
+        continue;
+      // empty text has the offset of the next one stored
+      if(other.size == 0) {
+        other.offset = 0;
+        continue;
+      }
+      auto const [it, added] = moved.emplace(other.offset, std::uint32_t(compacted.size()));
+      if(added)
+        compacted.append(texts_, other.offset, other.size);
+      other.offset = it->second;
+    }
+    texts_ = std::move(compacted);
+    unused_texts_ = 0;
+  }
+
+
+  void add_literal(std::string_view literal, std::uint32_t id) {
+    // literal known to some built level needs no rebuild
+    for(literal_level& level: levels_) {
+      std::uint32_t const literal_id = level.automaton.find(literal);
+      if(literal_id != aho_corasick::none) {
+        level.patterns[literal_id].push_back(id);
+        return;
+      }
+    }
+    // new literals are collected by a level not built yet
+    if(levels_.empty() || levels_.back().automaton.built())
+      levels_.emplace_back();
+    levels_.back().add(literal, id);
+  }
+
+
+  // merges the last level while it is not smaller than the previous one
+  void merge_levels() {
+    levels_.back().automaton.build();
+    while(levels_.size() > 1) {
+      literal_level& last = levels_.back();
+      literal_level& previous = levels_[levels_.size() - 2];
+      if(previous.literals.size() > last.literals.size())
+        break;
+      literal_level merged;
+      for(literal_level const* level: {&previous, &last})
+        for(std::size_t i = 0; i != level->literals.size(); ++i)
+          for(std::uint32_t id: level->patterns[i])
+            merged.add(level->literals[i], id);
+      merged.automaton.build();
+      levels_.pop_back();
+      levels_.back() = std::move(merged);
+    }
+  }
+
+}; // pattern_index
+
+
+} // chineseroom
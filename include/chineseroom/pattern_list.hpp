@@ -0,0 +1,209 @@
+/* This file is part of chineseroom library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "compiled_pattern.hpp"
+#include "text_signature.hpp"
+
+
+namespace chineseroom {
+
+
+// Short list of patterns compiled once and tried in order with the meaning
+// of selected(). Unlike pattern_set it builds no indexes, so it is cheap
+// to create from a comma separated specification kept in configuration.
+//
+// Result of matched_any doesn't depend on order of patterns, so they are
+// tried in order of evaluation which reorder() may change using hit
+// statistics gathered by every thread on its own.
+class pattern_list {
+public:
+
+  // hits of every pattern gathered by matched_any(text, statistics&)
+  struct statistics {
+    struct counter {
+      std::uint64_t tries;
+      std::uint64_t hits;
+    };
+
+    std::vector<counter> counters;
+    std::uint64_t texts{0};
+
+    void clear() noexcept {
+      std::fill(counters.begin(), counters.end(), counter{0, 0});
+      texts = 0;
+    }
+  };
+
+  pattern_list() = default;
+
+
+  explicit pattern_list(std::string_view patterns, char separator = ',') {
+    while(!patterns.empty()) {
+      std::size_t const last = patterns.find(separator);
+      std::string_view const each = patterns.substr(0, last);
+      if(!each.empty())
+        add(each);
+      if(last == std::string_view::npos)
+        break;
+      patterns.remove_prefix(last + 1);
+    }
+  }
+
+
+  explicit pattern_list(std::vector<std::string> const& patterns) {
+    for(auto const& each: patterns)
+      add(each);
+  }
+
+
+  pattern_list(std::initializer_list<char const*> patterns) {
+    for(auto const& each: patterns)
+      add(each);
+  }
+
+
+  std::size_t size() const noexcept { return patterns_.size(); }
+  bool empty() const noexcept { return patterns_.empty(); }
+
+  compiled_pattern const& operator [] (std::size_t i) const noexcept {
+    return patterns_[i];
+  }
+
+
+  // indices of patterns in order of evaluation
+  std::vector<std::uint32_t> const& order() const noexcept { return order_; }
+
+
+  bool matched_any(std::string_view text) const noexcept {
+    return evaluate(text, [](std::uint32_t, bool) { });
+  }
+
+
+  // the same as matched_any(text) counting tries and hits of every pattern
+  bool matched_any(std::string_view text, statistics& stats) const {
+    if(stats.counters.size() != patterns_.size())
+      stats.counters.resize(patterns_.size(), statistics::counter{0, 0});
+    ++stats.texts;
+    return evaluate(text, [&stats](std::uint32_t i, bool hit) {
+      ++stats.counters[i].tries;
+      stats.counters[i].hits += hit;
+    });
+  }
+
+
+  // Sorts patterns by hits per unit of estimated cost, so ones most likely
+  // to decide the result cheaply are tried first. Ties are broken by seeded
+  // hash of pattern index, the same seed and statistics give the same order.
+  void reorder(statistics const& stats, std::uint64_t seed = 0) {
+    std::vector<double> rank(patterns_.size());
+    std::vector<std::uint64_t> tie(patterns_.size());
+    for(std::uint32_t i = 0; i != patterns_.size(); ++i) {
+      statistics::counter const c = i < stats.counters.size()
+        ? stats.counters[i] : statistics::counter{0, 0};
+      // hit rate estimated with one imaginary miss and hit per pattern
+      double const rate = double(c.hits + 1) / double(c.tries + 2);
+      rank[i] = rate / double(cost(patterns_[i]));
+      tie[i] = mixed(seed + i);
+    }
+    std::stable_sort(order_.begin(), order_.end(),
+      [&](std::uint32_t lhs, std::uint32_t rhs) {
+        if(rank[lhs] != rank[rhs])
+          return rank[lhs] > rank[rhs];
+        return seed != 0 && tie[lhs] < tie[rhs];
+      });
+  }
+
+
+  // restores order of patterns in the list
+  void reset_order() {
+    std::iota(order_.begin(), order_.end(), std::uint32_t(0));
+  }
+
+
+private:
+
+  std::vector<compiled_pattern> patterns_;
+  std::vector<std::uint32_t> order_;
+  std::size_t includes_{0};
+
+
+  void add(std::string_view pattern) {
+    order_.push_back(std::uint32_t(patterns_.size()));
+    patterns_.emplace_back(pattern);
+    if(!patterns_.back().negated())
+      ++includes_;
+  }
+
+
+  // any matched '!' pattern rejects the text, the first matched pattern
+  // without it lets to skip the rest of such patterns
+  template<typename F>
+  bool evaluate(std::string_view text, F&& tried) const noexcept {
+    text_signature const signature{text};
+    bool included = includes_ == 0;
+    std::size_t untried = includes_;
+    for(std::uint32_t i: order_) {
+      compiled_pattern const& each = patterns_[i];
+      if(each.negated()) {
+        bool const hit = each.matched_body(text, signature);
+        tried(i, hit);
+        if(hit)
+          return false;
+      } else if(!included) {
+        included = each.matched_body(text, signature);
+        tried(i, included);
+        if(!included && --untried == 0)
+          return false;
+      }
+    }
+    return included;
+  }
+
+
+  // rough number of comparisons to match the pattern
+  static std::size_t cost(compiled_pattern const& pattern) noexcept {
+    return pattern.starred() ? 2 * pattern.atoms() + 2 : pattern.atoms() + 1;
+  }
+
+
+  static std::uint64_t mixed(std::uint64_t x) noexcept {
+    // splitmix64 finalizer
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+  }
+
+}; // pattern_list
+
+
+} // chineseroom
@@ -0,0 +1,162 @@
+/* This file is part of chineseroom library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "pattern_index.hpp"
+#include "split.hpp"
+
+
+namespace chineseroom {
+
+
+// Compiled list of patterns with the same meaning as selected(): text is
+// matched when it is matched by any pattern without '!' (or there are no such
+// patterns) and is not rejected by any '!' pattern. Bodies of patterns are
+// kept in pattern_index, so only patterns whose literals occur in the text
+// are verified. Patterns may be inserted and removed one by one.
+class pattern_set {
+public:
+
+  pattern_set() = default;
+
+
+  explicit pattern_set(std::vector<std::string> const& patterns) {
+    add_all(patterns, 1);
+  }
+
+
+  // patterns compiled by several threads, 0 to use every hardware thread;
+  // the set is the same as built by one thread
+  pattern_set(std::vector<std::string> const& patterns, unsigned threads) {
+    add_all(patterns, threads);
+  }
+
+
+  pattern_set(std::initializer_list<char const*> patterns) {
+    add_all(patterns, 1);
+  }
+
+
+  // comma separated list of patterns
+  explicit pattern_set(std::string const& patterns):
+    pattern_set{split(patterns, ',')}
+  { }
+
+
+  // number of patterns, ids of removed ones are reused by insert()
+  std::size_t size() const noexcept { return index_.size(); }
+  bool empty() const noexcept { return index_.empty(); }
+
+  // pattern by value: patterns kept as text, without wildcards or 'head*' and
+  // '*tail' ones, are compiled again on every call, so body(), negated() and
+  // literal() are cheaper when the pattern itself isn't needed
+  compiled_pattern operator [] (std::size_t id) const {
+    return index_[id];
+  }
+
+  // pattern without leading '!'
+  std::string_view body(std::size_t id) const noexcept { return index_.body(id); }
+  bool negated(std::size_t id) const noexcept { return index_.negated(id); }
+  // pattern without wildcards
+  bool literal(std::size_t id) const noexcept { return index_.literal(id); }
+
+
+  // approximate bytes taken by the set
+  memory_usage memory() const noexcept { return index_.memory(); }
+
+
+  // adds pattern patching indexes, returns its id
+  std::uint32_t insert(std::string_view pattern) {
+    std::uint32_t const id = index_.insert(pattern);
+    count(id, true);
+    return id;
+  }
+
+
+  // removes pattern with the id returned by insert() or the index of it in
+  // the list the set was created from
+  bool remove(std::uint32_t id) {
+    if(!index_.contains(id))
+      return false;
+    count(id, false);
+    return index_.remove(id);
+  }
+
+
+  bool matched_any(std::string_view text) const {
+    bool included = includes_ == 0;
+    bool rejected = false;
+
+    if(included && excludes_ == 0)
+      return true;
+
+    // include patterns need no verification once one of them matched
+    auto const wanted = [&](std::uint32_t each) {
+      return !included || index_.negated(each);
+    };
+
+    // false when the result is known
+    index_.matched(text, wanted, [&](std::uint32_t each) {
+      if(index_.negated(each))
+        rejected = true;
+      else
+        included = true;
+      return !rejected && !(included && excludes_ == 0);
+    });
+
+    return included && !rejected;
+  }
+
+
+private:
+
+  pattern_index index_;
+  std::size_t includes_{0};
+  std::size_t excludes_{0};
+
+
+  template<typename R> void add_all(R const& patterns, unsigned threads) {
+    index_.add_all(patterns, threads);
+    for(std::uint32_t id = 0; id != index_.size(); ++id)
+      count(id, true);
+  }
+
+
+  void count(std::uint32_t id, bool added) noexcept {
+    std::size_t& counter = index_.negated(id) ? excludes_ : includes_;
+    if(added)
+      ++counter;
+    else
+      --counter;
+  }
+
+}; // pattern_set
+
+
+} // chineseroom
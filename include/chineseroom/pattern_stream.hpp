@@ -0,0 +1,143 @@
+/* This file is part of chineseroom library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "ascii/ignore_case.hpp"
+#include "compiled_pattern.hpp"
+
+
+namespace chineseroom {
+
+
+// Resumable matching of compiled_pattern against a text coming in several
+// chunks, e.g. iovecs or parts of a ring buffer, without copying them into
+// one buffer. Keeps the set of atoms the text fed so far may continue from,
+// one bit per atom, so every character costs a step per active atom. The
+// pattern has to outlive the stream.
+class pattern_stream {
+public:
+
+  explicit pattern_stream(compiled_pattern const& pattern):
+    pattern_{&pattern},
+    active_((pattern.atoms() + 64) / 64),
+    next_(active_.size()) {
+    for(std::size_t i = 0; i != pattern.atoms(); ++i)
+      if(pattern.atom(i) == compiled_pattern::star_atom)
+        stars_.push_back(std::uint32_t(i));
+    reset();
+  }
+
+
+  void reset() noexcept {
+    std::fill(active_.begin(), active_.end(), 0);
+    set(active_, 0);
+    close(active_);
+    alive_ = true;
+  }
+
+
+  void feed(std::string_view chunk) noexcept {
+    for(char c: chunk) {
+      if(!alive_)
+        return;
+      step(c);
+    }
+  }
+
+
+  // result of pattern.matched() for the text fed so far
+  bool matched() const noexcept {
+    return test(active_, pattern_->atoms()) != pattern_->negated();
+  }
+
+
+private:
+
+  compiled_pattern const* pattern_;
+  // bit i is set when the text fed so far is matched by atoms before i
+  std::vector<std::uint64_t> active_;
+  std::vector<std::uint64_t> next_;
+  std::vector<std::uint32_t> stars_;
+  bool alive_{true};
+
+
+  static bool test(std::vector<std::uint64_t> const& bits, std::size_t i) noexcept {
+    return (bits[i >> 6] >> (i & 63)) & 1;
+  }
+
+
+  static void set(std::vector<std::uint64_t>& bits, std::size_t i) noexcept {
+    bits[i >> 6] |= std::uint64_t(1) << (i & 63);
+  }
+
+
+  // star may match empty text, so atom after active star is active too
+  void close(std::vector<std::uint64_t>& bits) const noexcept {
+    for(std::uint32_t star: stars_)
+      if(test(bits, star))
+        set(bits, star + 1);
+  }
+
+
+  bool atom_matched(std::size_t i, char c) const noexcept {
+    switch(pattern_->atom(i)) {
+      case compiled_pattern::literal_atom:
+        return pattern_->ignoring_case()
+          ? ascii::equal_ignoring_case(pattern_->symbol(i), c)
+          : pattern_->symbol(i) == c;
+      case compiled_pattern::any_atom:
+        return true;
+      default:
+        return pattern_->atom_class(i).test(c);
+    }
+  }
+
+
+  void step(char c) noexcept {
+    std::size_t const atoms = pattern_->atoms();
+    std::fill(next_.begin(), next_.end(), 0);
+    for(std::size_t w = 0; w != active_.size(); ++w)
+      for(std::uint64_t bits = active_[w]; bits != 0; bits &= bits - 1) {
+        std::size_t const i = w * 64 + std::size_t(ascii::detail::lowest_bit64(bits));
+        if(i == atoms)
+          continue;
+        if(pattern_->atom(i) == compiled_pattern::star_atom)
+          set(next_, i);
+        else if(atom_matched(i, c))
+          set(next_, i + 1);
+      }
+    close(next_);
+    active_.swap(next_);
+    alive_ = std::any_of(active_.begin(), active_.end(),
+                         [](std::uint64_t bits) { return bits != 0; });
+  }
+
+}; // pattern_stream
+
+
+} // chineseroom
@@ -0,0 +1,235 @@
+/* This file is part of chineseroom library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+
+namespace chineseroom {
+
+
+// Holder of the current snapshot of some compiled object, e.g. pattern_set,
+// that is replaced at runtime while other threads keep using it. Every
+// reading thread takes its own reader and pins the snapshot for the time
+// of matching: pinning stores epoch to a cache line of that reader only and
+// never locks. Writer builds new snapshot aside and publishes it with atomic
+// exchange; replaced snapshots are deleted once every reader pinned before
+// the exchange has unpinned.
+template<typename T> class reloadable {
+  static constexpr std::uint64_t idle = std::uint64_t(-1);
+
+  // epoch announced by a reader, on a cache line of its own
+  struct alignas(64) slot {
+    std::atomic<std::uint64_t> epoch{idle};
+    // pins alive, touched by the thread of the reader only
+    std::size_t depth{0};
+    slot* next{nullptr};
+    bool used{false};
+  };
+
+  struct retired {
+    T const* snapshot;
+    std::uint64_t epoch;
+  };
+
+public:
+
+  class pinned;
+
+
+  // per thread handle, it should not be shared by threads
+  class reader {
+  public:
+
+    reader() noexcept = default;
+    reader(reader const&) = delete;
+    reader& operator = (reader const&) = delete;
+
+    reader(reader&& other) noexcept:
+      owner_{std::exchange(other.owner_, nullptr)},
+      slot_{std::exchange(other.slot_, nullptr)}
+    { }
+
+    reader& operator = (reader&& other) noexcept {
+      if(this == &other)
+        return *this;
+      release();
+      owner_ = std::exchange(other.owner_, nullptr);
+      slot_ = std::exchange(other.slot_, nullptr);
+      return *this;
+    }
+
+    ~reader() { release(); }
+
+
+    // current snapshot stays alive until returned object is destroyed;
+    // nested pins keep the epoch of the outermost one, it protects every
+    // snapshot published after it
+    pinned pin() const noexcept {
+      if(slot_->depth++ == 0)
+        slot_->epoch.store(owner_->epoch_.load(std::memory_order_acquire));
+      return pinned{slot_, owner_->current_.load()};
+    }
+
+
+    template<typename F> decltype(auto) read(F&& f) const {
+      pinned const snapshot = pin();
+      return f(*snapshot);
+    }
+
+
+  private:
+
+    friend class reloadable;
+
+    reloadable* owner_{nullptr};
+    slot* slot_{nullptr};
+
+    reader(reloadable* owner, slot* s) noexcept: owner_{owner}, slot_{s} { }
+
+    void release() noexcept {
+      if(owner_ == nullptr)
+        return;
+      std::lock_guard<std::mutex> const lock{owner_->mutex_};
+      slot_->used = false;
+    }
+  }; // reader
+
+
+  class pinned {
+  public:
+
+    pinned(pinned const&) = delete;
+    pinned& operator = (pinned const&) = delete;
+
+    pinned(pinned&& other) noexcept:
+      slot_{std::exchange(other.slot_, nullptr)},
+      snapshot_{other.snapshot_}
+    { }
+
+    ~pinned() {
+      if(slot_ != nullptr && --slot_->depth == 0)
+        slot_->epoch.store(idle, std::memory_order_release);
+    }
+
+    T const& operator * () const noexcept { return *snapshot_; }
+    T const* operator -> () const noexcept { return snapshot_; }
+    T const* get() const noexcept { return snapshot_; }
+
+  private:
+
+    friend class reader;
+
+    slot* slot_;
+    T const* snapshot_;
+
+    pinned(slot* s, T const* snapshot) noexcept: slot_{s}, snapshot_{snapshot} { }
+  }; // pinned
+
+
+  explicit reloadable(T initial):
+    current_{new T{std::move(initial)}}
+  { }
+
+  reloadable(reloadable const&) = delete;
+  reloadable& operator = (reloadable const&) = delete;
+
+
+  // every reader should be destroyed before
+  ~reloadable() {
+    delete current_.load();
+    for(retired const& each: retired_)
+      delete each.snapshot;
+    while(slots_ != nullptr)
+      delete std::exchange(slots_, slots_->next);
+  }
+
+
+  reader make_reader() {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    slot* free = slots_;
+    while(free != nullptr && free->used)
+      free = free->next;
+    if(free == nullptr) {
+      free = new slot;
+      free->next = slots_;
+      slots_ = free;
+    }
+    free->used = true;
+    return reader{this, free};
+  }
+
+
+  // replaces current snapshot, previous one is deleted when it isn't pinned
+  void publish(T next) {
+    T const* const fresh = new T{std::move(next)};
+    std::lock_guard<std::mutex> const lock{mutex_};
+    T const* const previous = current_.exchange(fresh);
+    std::uint64_t const epoch = epoch_.fetch_add(1) + 1;
+    retired_.push_back(retired{previous, epoch});
+    collect();
+  }
+
+
+  // deletes replaced snapshots not pinned anymore, returns number of
+  // snapshots still waiting for readers
+  std::size_t reclaim() {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    collect();
+    return retired_.size();
+  }
+
+
+private:
+
+  // read by every reader, written only by publish
+  alignas(64) std::atomic<T const*> current_;
+  std::atomic<std::uint64_t> epoch_{0};
+  alignas(64) std::mutex mutex_;
+  slot* slots_{nullptr};
+  std::vector<retired> retired_;
+
+
+  // reader pinned with epoch e may hold snapshots retired after e only
+  void collect() {
+    std::uint64_t oldest = idle;
+    for(slot const* each = slots_; each != nullptr; each = each->next)
+      oldest = std::min(oldest, each->epoch.load());
+    auto const unpinned = [oldest](retired const& each) { return each.epoch <= oldest; };
+    for(retired const& each: retired_)
+      if(unpinned(each))
+        delete each.snapshot;
+    retired_.erase(std::remove_if(retired_.begin(), retired_.end(), unpinned), retired_.end());
+  }
+
+}; // reloadable
+
+
+} // chineseroom
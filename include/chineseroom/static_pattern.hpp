@@ -0,0 +1,259 @@
+/* This file is part of chineseroom library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <utility>
+#include "ascii/ignore_case.hpp"
+#include "char_class.hpp"
+#include "compiled_pattern.hpp"
+#include "wildcards.hpp"
+
+
+namespace chineseroom {
+
+
+// Pattern parsed during compilation the same way as compiled_pattern.
+// Object of it declared constexpr at namespace scope or as static member is
+// a template argument of matched<P>(text), which is unrolled for the
+// pattern: pieces without wildcards are compared by memcmp of constant
+// size, '?' and classes are checked at constant offsets and length of text
+// is compared to a constant.
+//
+//   static constexpr chineseroom::static_pattern system_files{"/etc/*.conf"};
+//   chineseroom::matched<system_files>(path);
+template<std::size_t N> class static_pattern {
+public:
+
+  using atom_kind = compiled_pattern::atom_kind;
+
+
+  constexpr static_pattern(char const (&pattern)[N]) noexcept:
+    static_pattern{std::string_view{pattern, N - 1}, false}
+  { }
+
+
+  // ASCII letters are matched regardless of their case
+  constexpr static_pattern(char const (&pattern)[N], ascii::ignore_case_t) noexcept:
+    static_pattern{std::string_view{pattern, N - 1}, true}
+  { }
+
+
+  constexpr bool negated() const noexcept { return negated_; }
+  constexpr bool starred() const noexcept { return pieces_ > 1; }
+  constexpr bool ignoring_case() const noexcept { return folded_; }
+  constexpr std::size_t min_length() const noexcept { return atoms_ - (pieces_ - 1); }
+
+  constexpr std::size_t atoms() const noexcept { return atoms_; }
+  constexpr std::uint16_t atom(std::size_t i) const noexcept { return kinds_[i]; }
+  constexpr char symbol(std::size_t i) const noexcept { return symbols_[i]; }
+  constexpr char const* symbols() const noexcept { return symbols_; }
+
+  constexpr char_class const& atom_class(std::size_t i) const noexcept {
+    return classes_[kinds_[i] - atom_kind::class_atom];
+  }
+
+  // pieces separated by '*'
+  constexpr std::size_t pieces() const noexcept { return pieces_; }
+  constexpr std::size_t piece_offset(std::size_t i) const noexcept { return offsets_[i]; }
+  constexpr std::size_t piece_size(std::size_t i) const noexcept { return sizes_[i]; }
+
+  // piece of plain characters only
+  constexpr bool exact(std::size_t piece) const noexcept {
+    for(std::size_t i = 0; i != sizes_[piece]; ++i)
+      if(kinds_[offsets_[piece] + i] != atom_kind::literal_atom)
+        return false;
+    return true;
+  }
+
+
+private:
+
+  char symbols_[N]{};
+  std::uint16_t kinds_[N]{};
+  char_class classes_[N]{};
+  std::size_t offsets_[N]{};
+  std::size_t sizes_[N]{};
+  std::size_t atoms_{0};
+  std::size_t classes_size_{0};
+  std::size_t pieces_{1};
+  bool negated_{false};
+  bool folded_{false};
+
+
+  constexpr static_pattern(std::string_view pattern, bool folded) noexcept: folded_{folded} {
+    negated_ = !pattern.empty() && pattern.front() == '!';
+    if(negated_)
+      pattern.remove_prefix(1);
+    parse(pattern);
+  }
+
+
+  constexpr void push_atom(char symbol, std::uint16_t kind) noexcept {
+    symbols_[atoms_] = symbol;
+    kinds_[atoms_] = kind;
+    ++atoms_;
+    if(kind == atom_kind::star_atom) {
+      offsets_[pieces_] = atoms_;
+      ++pieces_;
+    } else
+      ++sizes_[pieces_ - 1];
+  }
+
+
+  constexpr void parse(std::string_view pattern) noexcept {
+    char const* p = pattern.data();
+    char const* const end = p + pattern.size();
+
+    while(p != end)
+      switch(*p) {
+        case '*':
+          push_atom('*', atom_kind::star_atom);
+          ++p;
+          continue;
+        case '?':
+          push_atom('?', atom_kind::any_atom);
+          ++p;
+          continue;
+        case '[': {
+          char_class members;
+          bool inverted = false;
+          char const* const closed = detail::parse_class(p, end, inverted,
+            [&members](char first, char last) { members.set(first, last); });
+          if(closed == nullptr) {
+            // not closed class is just '['
+            push_atom('[', atom_kind::literal_atom);
+            ++p;
+            continue;
+          }
+          if(folded_)
+            members.fold_case();
+          if(inverted)
+            members.invert();
+          classes_[classes_size_] = members;
+          push_atom('[', std::uint16_t(atom_kind::class_atom + classes_size_));
+          ++classes_size_;
+          p = closed;
+          continue;
+        }
+        case '\\':
+          // escaped character or '\' at the end of pattern
+          if(p + 1 != end)
+            ++p;
+          push_atom(*p++, atom_kind::literal_atom);
+          continue;
+        default:
+          push_atom(*p++, atom_kind::literal_atom);
+          continue;
+      }
+  }
+
+}; // static_pattern
+
+
+namespace detail {
+
+  template<auto const& P, std::size_t I>
+  bool static_atom_matched(char c) noexcept {
+    constexpr std::uint16_t kind = P.atom(I);
+    if constexpr(kind == compiled_pattern::literal_atom) {
+      if constexpr(P.ignoring_case())
+        return ascii::equal_ignoring_case(c, P.symbol(I));
+      else
+        return c == P.symbol(I);
+    } else if constexpr(kind == compiled_pattern::any_atom)
+      return true;
+    else
+      return P.atom_class(I).test(c);
+  }
+
+
+  template<auto const& P, std::size_t Piece, std::size_t... I>
+  bool static_piece_matched(char const* text, std::index_sequence<I...>) noexcept {
+    constexpr std::size_t offset = P.piece_offset(Piece);
+    if constexpr(P.exact(Piece) && !P.ignoring_case())
+      return std::memcmp(text, P.symbols() + offset, sizeof...(I)) == 0;
+    else
+      return (static_atom_matched<P, offset + I>(text[I]) && ...);
+  }
+
+
+  template<auto const& P, std::size_t Piece>
+  bool static_piece_matched(char const* text) noexcept {
+    return static_piece_matched<P, Piece>(text, std::make_index_sequence<P.piece_size(Piece)>{});
+  }
+
+
+  // leftmost position of the piece in [from, to) moves from past it
+  template<auto const& P, std::size_t Piece>
+  bool static_piece_found(char const* text, std::size_t& from, std::size_t to) noexcept {
+    constexpr std::size_t size = P.piece_size(Piece);
+    if constexpr(P.exact(Piece) && !P.ignoring_case()) {
+      std::string_view const where{text + from, to - from};
+      std::size_t const found = where.find(std::string_view{P.symbols() + P.piece_offset(Piece), size});
+      if(found == std::string_view::npos)
+        return false;
+      from += found + size;
+      return true;
+    } else {
+      for(std::size_t i = from; i + size <= to; ++i)
+        if(static_piece_matched<P, Piece>(text + i)) {
+          from = i + size;
+          return true;
+        }
+      return false;
+    }
+  }
+
+
+  template<auto const& P, std::size_t... Middle>
+  bool static_body_matched(std::string_view text, std::index_sequence<Middle...>) noexcept {
+    if constexpr(!P.starred())
+      return text.size() == P.min_length() && static_piece_matched<P, 0>(text.data());
+    else {
+      constexpr std::size_t last = P.pieces() - 1;
+      if(text.size() < P.min_length())
+        return false;
+      std::size_t from = P.piece_size(0);
+      std::size_t const to = text.size() - P.piece_size(last);
+      return static_piece_matched<P, 0>(text.data())
+          && static_piece_matched<P, last>(text.data() + to)
+          && (static_piece_found<P, Middle + 1>(text.data(), from, to) && ...);
+    }
+  }
+
+} // detail
+
+
+// the same as compiled_pattern{P}.matched(text) unrolled for the pattern
+template<auto const& P>
+bool matched(std::string_view text) noexcept {
+  constexpr std::size_t middle = P.pieces() > 2 ? P.pieces() - 2 : 0;
+  return detail::static_body_matched<P>(text, std::make_index_sequence<middle>{}) != P.negated();
+}
+
+
+} // chineseroom
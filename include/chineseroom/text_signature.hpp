@@ -0,0 +1,100 @@
+/* This file is part of chineseroom library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include "ascii/ignore_case.hpp"
+
+
+namespace chineseroom {
+
+
+namespace detail {
+
+  constexpr std::array<std::uint64_t, 256> make_signature_bits() noexcept {
+    std::array<std::uint64_t, 256> bits{};
+    for(unsigned c = 0; c != 256; ++c) {
+      // letters of both cases share a bit, so the same signature fits
+      // patterns ignoring case
+      unsigned const lowered = ascii::detail::lower_case_table[c];
+      bits[c] = std::uint64_t(1) << ((lowered * 0x9e3779b1u) >> 26 & 63);
+    }
+    return bits;
+  }
+
+  inline constexpr std::array<std::uint64_t, 256> signature_bits = make_signature_bits();
+
+
+  constexpr std::uint64_t signature_bit(char c) noexcept {
+    return signature_bits[static_cast<unsigned char>(c)];
+  }
+
+} // detail
+
+
+// Cheap summary of a text computed once to reject most of patterns with a
+// few bitwise operations: size, 64-bit bloom filter of its characters and
+// its first and last characters.
+class text_signature {
+public:
+
+  text_signature() noexcept = default;
+
+
+  explicit text_signature(std::string_view text) noexcept:
+    size_{text.size()} {
+    if(text.empty())
+      return;
+    first_ = text.front();
+    last_ = text.back();
+    for(char c: text)
+      bloom_ |= detail::signature_bit(c);
+  }
+
+
+  std::size_t size() const noexcept { return size_; }
+  std::uint64_t bloom() const noexcept { return bloom_; }
+  char first() const noexcept { return first_; }
+  char last() const noexcept { return last_; }
+
+
+  // true if text may contain every character with given bloom bits
+  bool contains(std::uint64_t required) const noexcept {
+    return (bloom_ & required) == required;
+  }
+
+
+private:
+
+  std::size_t size_{0};
+  std::uint64_t bloom_{0};
+  char first_{0};
+  char last_{0};
+
+}; // text_signature
+
+
+} // chineseroom
@@ -0,0 +1,252 @@
+/* This file is part of chineseroom library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "literal_index.hpp"
+
+
+namespace chineseroom {
+
+
+// Trie of subscriptions to subjects made of segments, e.g. "orders.eu.new".
+// A filter segment '*' matches any one segment, the last segment '>' matches
+// one or more segments and the last segment '**' matches zero or more ones.
+// Matching a subject visits only branches its segments lead to, so it takes
+// time proportional to the depth of the subject times the number of
+// wildcard branches, not to the number of subscriptions. Const member
+// functions may be called by many threads at once; to change subscriptions
+// while matching, keep the router in reloadable.
+template<typename T> class topic_router {
+public:
+
+  explicit topic_router(char separator = '.'): separator_{separator} {
+    nodes_.emplace_back();
+  }
+
+
+  // number of subscriptions
+  std::size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0; }
+
+
+  // returns false if '>' or '**' isn't the last segment of the filter
+  bool subscribe(std::string_view filter, T subscriber) {
+    if(!valid(filter))
+      return false;
+    nodes_[make_path(filter)].subscribers.push_back(std::move(subscriber));
+    ++size_;
+    return true;
+  }
+
+
+  // removes one subscription of the subscriber to the filter
+  bool unsubscribe(std::string_view filter, T const& subscriber) {
+    std::uint32_t const n = find_path(filter);
+    if(n == none)
+      return false;
+    auto& subscribers = nodes_[n].subscribers;
+    auto const it = std::find(subscribers.begin(), subscribers.end(), subscriber);
+    if(it == subscribers.end())
+      return false;
+    subscribers.erase(it);
+    --size_;
+    return true;
+  }
+
+
+  // calls f(subscriber) for every subscription matching the subject
+  template<typename F> void match(std::string_view subject, F&& f) const {
+    visit(0, subject, false, f);
+  }
+
+
+  std::vector<T> matched(std::string_view subject) const {
+    std::vector<T> subscribers;
+    match(subject, [&subscribers](T const& each) { subscribers.push_back(each); });
+    return subscribers;
+  }
+
+
+private:
+
+  static constexpr std::uint32_t none = std::uint32_t(-1);
+
+  struct node {
+    // children by wildcard segment
+    std::uint32_t any_one{none};
+    std::uint32_t one_or_more{none};
+    std::uint32_t zero_or_more{none};
+    std::vector<T> subscribers;
+  };
+
+  char separator_;
+  std::vector<node> nodes_;
+  // ids of literal segments
+  literal_index segment_ids_;
+  std::vector<std::string> segments_;
+  // children by literal segment, keyed by parent and segment ids
+  std::unordered_map<std::uint64_t, std::uint32_t> children_;
+  std::size_t size_{0};
+
+
+  static std::uint64_t key(std::uint32_t parent, std::uint32_t segment) noexcept {
+    return (std::uint64_t(parent) << 32) | segment;
+  }
+
+
+  // cuts the first segment of rest, sets ended if it was the last one
+  std::string_view next_segment(std::string_view& rest, bool& ended) const noexcept {
+    std::size_t const last = rest.find(separator_);
+    std::string_view const segment = rest.substr(0, last);
+    if(last == std::string_view::npos) {
+      rest = std::string_view{};
+      ended = true;
+    } else
+      rest.remove_prefix(last + 1);
+    return segment;
+  }
+
+
+  bool valid(std::string_view filter) const noexcept {
+    bool ended = false;
+    while(!ended) {
+      std::string_view const segment = next_segment(filter, ended);
+      if((segment == ">" || segment == "**") && !ended)
+        return false;
+    }
+    return true;
+  }
+
+
+  std::uint32_t segment_id(std::string_view segment) const noexcept {
+    std::uint32_t found = none;
+    auto const get = [this](std::uint32_t id) { return std::string_view{segments_[id]}; };
+    segment_ids_.find(segment, get, [&found](std::uint32_t id) {
+      found = id;
+      return false;
+    });
+    return found;
+  }
+
+
+  std::uint32_t literal_child(std::uint32_t parent, std::string_view segment) const noexcept {
+    std::uint32_t const id = segment_id(segment);
+    if(id == none)
+      return none;
+    auto const it = children_.find(key(parent, id));
+    return it == children_.end() ? none : it->second;
+  }
+
+
+  std::uint32_t* wildcard_child(node& n, std::string_view segment) noexcept {
+    if(segment == "*")
+      return &n.any_one;
+    if(segment == ">")
+      return &n.one_or_more;
+    if(segment == "**")
+      return &n.zero_or_more;
+    return nullptr;
+  }
+
+
+  std::uint32_t make_path(std::string_view filter) {
+    std::uint32_t n = 0;
+    bool ended = false;
+    while(!ended) {
+      std::string_view const segment = next_segment(filter, ended);
+      std::uint32_t next;
+      if(std::uint32_t* const wildcard = wildcard_child(nodes_[n], segment)) {
+        next = *wildcard;
+        if(next == none) {
+          next = std::uint32_t(nodes_.size());
+          *wildcard_child(nodes_[n], segment) = next;
+          nodes_.emplace_back();
+        }
+      } else {
+        std::uint32_t id = segment_id(segment);
+        if(id == none) {
+          id = std::uint32_t(segments_.size());
+          segments_.emplace_back(segment);
+          segment_ids_.insert(segment, id);
+        }
+        auto const inserted = children_.emplace(key(n, id), std::uint32_t(nodes_.size()));
+        next = inserted.first->second;
+        if(inserted.second)
+          nodes_.emplace_back();
+      }
+      n = next;
+    }
+    return n;
+  }
+
+
+  std::uint32_t find_path(std::string_view filter) {
+    std::uint32_t n = 0;
+    bool ended = false;
+    while(!ended && n != none) {
+      std::string_view const segment = next_segment(filter, ended);
+      std::uint32_t const* const wildcard = wildcard_child(nodes_[n], segment);
+      n = wildcard != nullptr ? *wildcard : literal_child(n, segment);
+    }
+    return n;
+  }
+
+
+  template<typename F>
+  void report(std::uint32_t n, F& f) const {
+    if(n == none)
+      return;
+    for(T const& each: nodes_[n].subscribers)
+      f(each);
+  }
+
+
+  template<typename F>
+  void visit(std::uint32_t n, std::string_view rest, bool ended, F& f) const {
+    node const& current = nodes_[n];
+    report(current.zero_or_more, f);
+    if(ended) {
+      report(n, f);
+      return;
+    }
+    report(current.one_or_more, f);
+
+    std::string_view const segment = next_segment(rest, ended);
+    std::uint32_t const literal = literal_child(n, segment);
+    if(literal != none)
+      visit(literal, rest, ended, f);
+    if(current.any_one != none)
+      visit(current.any_one, rest, ended, f);
+  }
+
+}; // topic_router
+
+
+} // chineseroom
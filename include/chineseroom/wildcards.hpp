@@ -23,26 +23,37 @@
 #pragma once
 
 
+#include <array>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include "ascii/ignore_case.hpp"
 #include "split.hpp"
 
 
 namespace chineseroom {
+
+
+// span of text matched by a wildcard
+struct capture {
+  std::size_t offset;
+  std::size_t size;
+};
   
   
 namespace detail {
 
-  template<typename C> bool has_wildcards(C const* chars) {
+  template<typename C> bool has_wildcards(C const* chars, std::size_t size) {
 
-    if(chars == nullptr)
+    if(size == 0)
       return false;
 
     if(*chars == '!')
       return true;
 
-    for(C const* c = chars; *c != '\0'; ++c)
+    for(C const* c = chars; c != chars + size; ++c)
       switch(*c) {
-        case '*': case '?':
+        case '*': case '?': case '[': case '\\':
           return true;
         default:
           continue;
@@ -51,6 +62,15 @@ namespace detail {
     return false;
   }
 
+
+  template<typename C> bool has_wildcards(C const* chars) {
+
+    if(chars == nullptr)
+      return false;
+
+    return has_wildcards(chars, std::char_traits<C>::length(chars));
+  }
+
 }
 
 
@@ -64,75 +84,260 @@ inline bool has_wildcards(wchar_t const* chars) {
 }
 
 inline bool has_wildcards(std::string const& s) {
-  return has_wildcards(s.data());
+  return detail::has_wildcards(s.data(), s.size());
 }
 
 inline bool has_wildcards(std::wstring const& s) {
-  return has_wildcards(s.data());
+  return detail::has_wildcards(s.data(), s.size());
+}
+
+inline bool has_wildcards(std::string_view s) {
+  return detail::has_wildcards(s.data(), s.size());
+}
+
+inline bool has_wildcards(std::wstring_view s) {
+  return detail::has_wildcards(s.data(), s.size());
 }
 
 
 namespace detail {
 
-template<typename C> bool matched(C const* pattern, C const* text) {
-  
-  if(pattern == text)
+// characters compared as they are
+struct exact_chars {
+  template<typename C> static bool equal(C lhs, C rhs) noexcept {
+    return lhs == rhs;
+  }
+
+  template<typename C> static bool in_range(C first, C last, C c) noexcept {
+    using U = std::make_unsigned_t<C>;
+    return U(first) <= U(c) && U(c) <= U(last);
+  }
+
+  template<typename C> static C const* find(C const* text, std::size_t n, C c) noexcept {
+    return std::char_traits<C>::find(text, n, c);
+  }
+};
+
+
+// ASCII letters compared regardless of their case
+struct ascii_folded_chars {
+  static bool equal(char lhs, char rhs) noexcept {
+    return ascii::equal_ignoring_case(lhs, rhs);
+  }
+
+  static bool in_range(char first, char last, char c) noexcept {
+    char const lower = ascii::to_lower(c);
+    char const upper = lower >= 'a' && lower <= 'z' ? char(lower - 'a' + 'A') : c;
+    return exact_chars::in_range(first, last, lower)
+        || exact_chars::in_range(first, last, upper);
+  }
+
+  static char const* find(char const* text, std::size_t n, char c) noexcept {
+    std::size_t const found = ascii::find_ignoring_case({text, n}, {&c, 1});
+    return found == std::string_view::npos ? nullptr : text + found;
+  }
+};
+
+
+// parses '[...]' class pattern points to, calling f(first, last) for every
+// range of it; returns position after ']' or nullptr if class is not closed
+template<typename C, typename F>
+constexpr C const* parse_class(C const* pattern, C const* pattern_end, bool& inverted, F&& f) {
+  C const* p = pattern + 1;
+  inverted = p != pattern_end && *p == '!';
+  if(inverted)
+    ++p;
+
+  for(bool first = true; p != pattern_end; first = false) {
+    // ']' right after '[' or '[!' is a member of class
+    if(*p == ']' && !first)
+      return p + 1;
+    C low = *p++;
+    if(low == '\\' && p != pattern_end)
+      low = *p++;
+    C high = low;
+    if(p != pattern_end && *p == '-' && p + 1 != pattern_end && p[1] != ']') {
+      ++p;
+      high = *p++;
+      if(high == '\\' && p != pattern_end)
+        high = *p++;
+    }
+    f(low, high);
+  }
+
+  return nullptr;
+}
+
+
+// jumps to the next occurrence of the character following a star, if it is
+// a plain one, instead of trying every position of the text
+template<typename E, typename C> bool skipped_to_next(C const* pattern, C const* pattern_end,
+                                                      C const*& text, C const* text_end) {
+  if(pattern == pattern_end)
     return true;
-  
-  if(pattern == nullptr)
-    return *text == '\0';
-  
-  if(text == nullptr)
-    return *pattern == '\0';
-  
+  switch(*pattern) {
+    case '*': case '?': case '[':
+      return true;
+    case '\\':
+      if(++pattern == pattern_end)
+        --pattern;
+      break;
+    default:
+      break;
+  }
+  text = E::find(text, std::size_t(text_end - text), *pattern);
+  return text != nullptr;
+}
+
+
+// matching without recording captures
+struct no_captures {
+  void open(std::size_t, std::size_t) noexcept { }
+  void close(std::size_t, std::size_t) noexcept { }
+};
+
+
+// records spans of wildcards which fit into captures
+struct capture_recorder {
+  capture* captures;
+  std::size_t capacity;
+
+  void open(std::size_t wildcard, std::size_t offset) noexcept {
+    if(wildcard < capacity)
+      captures[wildcard] = capture{offset, 0};
+  }
+
+  void close(std::size_t wildcard, std::size_t end) noexcept {
+    if(wildcard < capacity)
+      captures[wildcard].size = end - captures[wildcard].offset;
+  }
+};
+
+
+template<typename C, typename E = exact_chars, typename R = no_captures>
+bool matched(C const* pattern, std::size_t pattern_size,
+             C const* text, std::size_t text_size, R&& recorder = R{}) {
+
+  C const* const pattern_end = pattern + pattern_size;
+  C const* const text_begin = text;
+  C const* const text_end = text + text_size;
   C const* last_text = nullptr;
   C const* last_pattern = nullptr;
+  // wildcards are numbered in order of pattern for captures
+  std::size_t wildcard = 0;
+  std::size_t last_wildcard = 0;
   bool without_negation = true;
 
-  if(*pattern == '!') {
+  if(pattern != pattern_end && *pattern == '!') {
     without_negation = false;
     ++pattern;
   }
-  
-  while(*text != '\0')
-    switch(*pattern) {
-      case '*':
-        // new star-loop: backup positions in pattern and text
-        last_text = text;
-        last_pattern = ++pattern;
-        continue;
-      case '?':
-        // ? matched any character or we matched the current non-NUL character
-        text++;
-        pattern++;
-        continue;
-      default:
-        if(*pattern == *text) {
-          // we matched the current non-NUL character
-          text++;
-          pattern++;
-        } else {
-          // if no stars we fail to match
-          if (last_pattern == nullptr)
+
+  while(text != text_end) {
+    bool same = false;
+    bool single = false;
+    C const* next = pattern + 1;
+
+    if(pattern != pattern_end)
+      switch(*pattern) {
+        case '*':
+          // new star-loop: backup positions in pattern and text
+          last_pattern = ++pattern;
+          last_wildcard = wildcard++;
+          recorder.open(last_wildcard, std::size_t(text - text_begin));
+          if(!skipped_to_next<E>(pattern, pattern_end, text, text_end))
             return without_negation ? false : true;
-          // star-loop: backtrack to the last * by restoring the backup positions 
-          // in the pattern and text
-          text = ++last_text;
-          pattern = last_pattern;
+          last_text = text;
+          recorder.close(last_wildcard, std::size_t(text - text_begin));
+          continue;
+        case '?':
+          // ? matched any character
+          same = true;
+          single = true;
+          break;
+        case '[': {
+          bool inverted = false;
+          bool member = false;
+          C const* const closed = parse_class(pattern, pattern_end, inverted,
+            [&member, text](C first, C last) {
+              member = member || E::in_range(first, last, *text);
+            });
+          if(closed == nullptr) {
+            // not closed class is just '['
+            same = E::equal(*pattern, *text);
+          } else {
+            same = member != inverted;
+            single = true;
+            next = closed;
+          }
+          break;
         }
+        case '\\':
+          // escaped character or '\\' at the end of pattern
+          if(next != pattern_end)
+            ++next;
+          same = E::equal(*(next - 1), *text);
+          break;
+        default:
+          same = E::equal(*pattern, *text);
+          break;
+      }
+
+    if(same) {
+      // we matched the current character
+      if(single) {
+        recorder.open(wildcard, std::size_t(text - text_begin));
+        recorder.close(wildcard++, std::size_t(text - text_begin) + 1);
+      }
+      ++text;
+      pattern = next;
+      continue;
     }
-  
+
+    // if no stars we fail to match
+    if(last_pattern == nullptr)
+      return without_negation ? false : true;
+    // star-loop: backtrack to the last * by restoring the backup positions
+    // in the pattern and text
+    text = ++last_text;
+    pattern = last_pattern;
+    wildcard = last_wildcard + 1;
+    if(!skipped_to_next<E>(pattern, pattern_end, text, text_end))
+      return without_negation ? false : true;
+    last_text = text;
+    recorder.close(last_wildcard, std::size_t(text - text_begin));
+  }
+
   // ignore trailing stars
-  while(*pattern == '*')
+  while(pattern != pattern_end && *pattern == '*') {
+    recorder.open(wildcard, text_size);
+    recorder.close(wildcard++, text_size);
     ++pattern;
-  
+  }
+
   // at end of text means success if nothing else is left to match
-  if(*pattern != '\0')
+  if(pattern != pattern_end)
     return without_negation ? false : true;
-  
+
   return without_negation ? true : false;
 }
 
+
+template<typename C> bool matched(C const* pattern, C const* text) {
+  
+  if(pattern == text)
+    return true;
+  
+  if(pattern == nullptr)
+    return *text == '\0';
+  
+  if(text == nullptr)
+    return *pattern == '\0';
+
+  return matched(pattern, std::char_traits<C>::length(pattern),
+                 text, std::char_traits<C>::length(text));
+}
+
 } // detail
 
 
@@ -157,7 +362,7 @@ inline bool matched(std::string const& pattern, char const* text) {
 }
 
 inline bool matched(std::string const& pattern, std::string const& text) {
-  return matched(pattern.data(), text.data());
+  return detail::matched(pattern.data(), pattern.size(), text.data(), text.size());
 }
 
 inline bool matched(std::wstring const& pattern, wchar_t const* text) {
@@ -165,111 +370,341 @@ inline bool matched(std::wstring const& pattern, wchar_t const* text) {
 }
 
 inline bool matched(std::wstring const& pattern, std::wstring const& text) {
-  return matched(pattern.data(), text.data());
+  return detail::matched(pattern.data(), pattern.size(), text.data(), text.size());
+}
+
+// pattern and text are not required to be NUL terminated
+inline bool matched(char const* pattern, std::size_t pattern_size,
+                    char const* text, std::size_t text_size) {
+  return detail::matched(pattern, pattern_size, text, text_size);
+}
+
+inline bool matched(wchar_t const* pattern, std::size_t pattern_size,
+                    wchar_t const* text, std::size_t text_size) {
+  return detail::matched(pattern, pattern_size, text, text_size);
+}
+
+inline bool matched(std::string_view pattern, std::string_view text) {
+  return detail::matched(pattern.data(), pattern.size(), text.data(), text.size());
+}
+
+inline bool matched(std::wstring_view pattern, std::wstring_view text) {
+  return detail::matched(pattern.data(), pattern.size(), text.data(), text.size());
+}
+
+// ASCII letters of pattern and text are matched regardless of their case
+inline bool matched(std::string_view pattern, std::string_view text, ascii::ignore_case_t) {
+  return detail::matched<char, detail::ascii_folded_chars>(pattern.data(), pattern.size(),
+                                                           text.data(), text.size());
+}
+
+// matches and stores spans of every '*', '?' and '[...]' in order of pattern,
+// as many as fit into captures; stars take as little as they can except the
+// last one. Captures are meaningless if text is not matched or pattern is '!'
+inline bool match_captures(std::string_view pattern, std::string_view text,
+                           capture* captures, std::size_t capacity) {
+  return detail::matched<char>(pattern.data(), pattern.size(), text.data(), text.size(),
+                               detail::capture_recorder{captures, capacity});
 }
 
+template<std::size_t N>
+bool match_captures(std::string_view pattern, std::string_view text,
+                    std::array<capture, N>& captures) {
+  return match_captures(pattern, text, captures.data(), N);
+}
+
+namespace detail {
+
+  template<typename C> bool negated(C const* pattern) {
+    return pattern != nullptr && *pattern == '!';
+  }
+
+  template<typename C> bool negated(std::basic_string<C> const& pattern) {
+    return !pattern.empty() && pattern.front() == '!';
+  }
+
+  // text is matched by every pattern, '!' pattern matches texts its body
+  // doesn't
+  template<typename L, typename T> bool matched_all(L const& patterns, T const& text) {
+    for(auto const& each_pattern: patterns)
+      if(!chineseroom::matched(each_pattern, text))
+        return false;
+    return true;
+  }
+
+  // text is selected when any pattern without '!' matches it (or there are
+  // no such patterns) and no '!' pattern rejects it
+  template<typename L, typename T> bool selected(L const& patterns, T const& text) {
+    bool has_includes = false;
+    bool included = false;
+    for(auto const& each_pattern: patterns)
+      if(negated(each_pattern)) {
+        if(!chineseroom::matched(each_pattern, text))
+          return false;
+      } else {
+        has_includes = true;
+        if(!included && chineseroom::matched(each_pattern, text))
+          included = true;
+      }
+    return included || !has_includes;
+  }
+
+} // detail
+
+
+// Text is matched by every pattern of the list
 inline bool matched_any(std::initializer_list<char const*> const& patterns, char const* text) {
-  for(auto const& each_pattern: patterns)
-    if(!matched(each_pattern, text))
-      return false;
-  return true;
+  return detail::matched_all(patterns, text);
 }
 
 inline bool matched_any(std::initializer_list<char const*> const& patterns, std::string const& text) {
-  matched_any(patterns, text.data());
+  return matched_any(patterns, text.data());
 }
 
 inline bool matched_any(std::initializer_list<wchar_t const*> const& patterns, wchar_t const* text) {
-  for(auto const& each_pattern: patterns)
-    if(!matched(each_pattern, text))
-      return false;
-  return true;
+  return detail::matched_all(patterns, text);
 }
 
 inline bool matched_any(std::initializer_list<wchar_t const*> const& patterns, std::wstring const& text) {
-  matched_any(patterns, text.data());
+  return matched_any(patterns, text.data());
 }
 
 inline bool matched_any(std::initializer_list<std::string> const& patterns, char const* text) {
-  for(auto const& each_pattern: patterns)
-    if(!matched(each_pattern, text))
-      return false;
-  return true;
+  return detail::matched_all(patterns, text);
 }
 
 inline bool matched_any(std::initializer_list<std::string> const& patterns, std::string const& text) {
-  matched_any(patterns, text.data());
+  return matched_any(patterns, text.data());
 }
 
-inline bool matched(std::initializer_list<std::wstring> const& patterns, wchar_t const* text) {
-  for(auto const& each_pattern: patterns)
-    if(!matched(each_pattern, text))
-      return false;
-  return true;
+inline bool matched_any(std::initializer_list<std::wstring> const& patterns, wchar_t const* text) {
+  return detail::matched_all(patterns, text);
 }
 
 inline bool matched_any(std::initializer_list<std::wstring> const& patterns, std::wstring const& text) {
-  matched(patterns, text.data());
+  return matched_any(patterns, text.data());
 }
 
 inline bool matched_any(std::vector<char const*> const& patterns, char const* text) {
-  for(auto const& each_pattern: patterns)
-    if(!matched(each_pattern, text))
-      return false;
-  return true;
+  return detail::matched_all(patterns, text);
 }
 
 inline bool matched_any(std::vector<char const*> const& patterns, std::string const& text) {
-  matched_any(patterns, text.data());
+  return matched_any(patterns, text.data());
 }
 
 inline bool matched_any(std::vector<wchar_t const*> const& patterns, wchar_t const* text) {
-  for(auto const& each_pattern: patterns)
-    if(!matched(each_pattern, text))
-      return false;
-  return true;
+  return detail::matched_all(patterns, text);
 }
 
 inline bool matched_any(std::vector<wchar_t const*> const& patterns, std::wstring const& text) {
-  matched_any(patterns, text.data());
+  return matched_any(patterns, text.data());
 }
 
 inline bool matched_any(std::vector<std::string> const& patterns, char const* text) {
-  for(auto const& each_pattern: patterns)
-    if(!matched(each_pattern, text))
-      return false;
-  return true;
+  return detail::matched_all(patterns, text);
 }
 
 inline bool matched_any(std::vector<std::string> const& patterns, std::string const& text) {
-  matched_any(patterns, text.data());
+  return matched_any(patterns, text.data());
 }
 
 inline bool matched_any(std::vector<std::wstring> const& patterns, wchar_t const* text) {
-  for(auto const& each_pattern: patterns)
-    if(!matched(each_pattern, text))
-      return false;
-  return true;
+  return detail::matched_all(patterns, text);
 }
 
 inline bool matched_any(std::vector<std::wstring> const& patterns, std::wstring const& text) {
-  matched_any(patterns, text.data());
+  return matched_any(patterns, text.data());
+}
+
+
+// Text is selected by the list as by pattern_set: any pattern without '!'
+// (if there are such) matches it and no '!' pattern rejects it
+inline bool selected(std::initializer_list<char const*> const& patterns, char const* text) {
+  return detail::selected(patterns, text);
+}
+
+inline bool selected(std::initializer_list<char const*> const& patterns, std::string const& text) {
+  return selected(patterns, text.data());
+}
+
+inline bool selected(std::initializer_list<wchar_t const*> const& patterns, wchar_t const* text) {
+  return detail::selected(patterns, text);
+}
+
+inline bool selected(std::initializer_list<wchar_t const*> const& patterns, std::wstring const& text) {
+  return selected(patterns, text.data());
+}
+
+inline bool selected(std::initializer_list<std::string> const& patterns, char const* text) {
+  return detail::selected(patterns, text);
+}
+
+inline bool selected(std::initializer_list<std::string> const& patterns, std::string const& text) {
+  return selected(patterns, text.data());
+}
+
+inline bool selected(std::initializer_list<std::wstring> const& patterns, wchar_t const* text) {
+  return detail::selected(patterns, text);
+}
+
+inline bool selected(std::initializer_list<std::wstring> const& patterns, std::wstring const& text) {
+  return selected(patterns, text.data());
+}
+
+inline bool selected(std::vector<char const*> const& patterns, char const* text) {
+  return detail::selected(patterns, text);
+}
+
+inline bool selected(std::vector<char const*> const& patterns, std::string const& text) {
+  return selected(patterns, text.data());
 }
 
+inline bool selected(std::vector<wchar_t const*> const& patterns, wchar_t const* text) {
+  return detail::selected(patterns, text);
+}
+
+inline bool selected(std::vector<wchar_t const*> const& patterns, std::wstring const& text) {
+  return selected(patterns, text.data());
+}
+
+inline bool selected(std::vector<std::string> const& patterns, char const* text) {
+  return detail::selected(patterns, text);
+}
+
+inline bool selected(std::vector<std::string> const& patterns, std::string const& text) {
+  return selected(patterns, text.data());
+}
+
+inline bool selected(std::vector<std::wstring> const& patterns, wchar_t const* text) {
+  return detail::selected(patterns, text);
+}
+
+inline bool selected(std::vector<std::wstring> const& patterns, std::wstring const& text) {
+  return selected(patterns, text.data());
+}
+
+namespace detail {
+
+  // calls f(pattern, size) for every pattern of separated list walked in
+  // place, empty ones are skipped; stops when f returns false
+  template<typename C, typename F>
+  bool for_each_listed(C const* patterns, std::size_t patterns_size, C separator, F&& f) {
+    C const* const end = patterns + patterns_size;
+    for(C const* first = patterns; first < end; ) {
+      C const* last = std::char_traits<C>::find(first, std::size_t(end - first), separator);
+      if(last == nullptr)
+        last = end;
+      std::size_t const size = std::size_t(last - first);
+      if(size != 0 && !f(first, size))
+        return false;
+      first = last + 1;
+    }
+    return true;
+  }
+
+
+  template<typename C>
+  bool matched_all_listed(C const* patterns, std::size_t patterns_size, C separator,
+                          C const* text, std::size_t text_size) {
+    return for_each_listed(patterns, patterns_size, separator,
+                           [&](C const* pattern, std::size_t size) {
+      return matched(pattern, size, text, text_size);
+    });
+  }
+
+
+  template<typename C>
+  bool selected_listed(C const* patterns, std::size_t patterns_size, C separator,
+                       C const* text, std::size_t text_size) {
+    bool has_includes = false;
+    bool included = false;
+    bool const kept = for_each_listed(patterns, patterns_size, separator,
+                                      [&](C const* pattern, std::size_t size) {
+      if(*pattern == '!')
+        return matched(pattern, size, text, text_size);
+      has_includes = true;
+      if(!included && matched(pattern, size, text, text_size))
+        included = true;
+      return true;
+    });
+    return kept && (included || !has_includes);
+  }
+
+} // detail
+
+
+// comma separated patterns are walked in place without any allocation
 inline bool matched_any(std::string const& patterns, char const* text) {
-  return matched_any(split(patterns, ','), text);
+  // null text is matched by no pattern, so only a list without any accepts it
+  if(text == nullptr)
+    return patterns.find_first_not_of(',') == std::string::npos;
+  return detail::matched_all_listed(patterns.data(), patterns.size(), ',',
+                                    text, std::char_traits<char>::length(text));
 }
 
 inline bool matched_any(std::string const& patterns, std::string const& text) {
-  return matched_any(split(patterns, ','), text);
+  return detail::matched_all_listed(patterns.data(), patterns.size(), ',',
+                                    text.data(), text.size());
 }
 
 inline bool matched_any(std::wstring const& patterns, wchar_t const* text) {
-  return matched_any(split(patterns, ','), text);
+  // null text is matched by no pattern, so only a list without any accepts it
+  if(text == nullptr)
+    return patterns.find_first_not_of(L',') == std::wstring::npos;
+  return detail::matched_all_listed(patterns.data(), patterns.size(), L',',
+                                    text, std::char_traits<wchar_t>::length(text));
 }
 
 inline bool matched_any(std::wstring const& patterns, std::wstring const& text) {
-  return matched_any(split(patterns, ','), text);
+  return detail::matched_all_listed(patterns.data(), patterns.size(), L',',
+                                    text.data(), text.size());
+}
+
+inline bool matched_any(std::string_view patterns, std::string_view text) {
+  return detail::matched_all_listed(patterns.data(), patterns.size(), ',',
+                                    text.data(), text.size());
+}
+
+inline bool matched_any(std::wstring_view patterns, std::wstring_view text) {
+  return detail::matched_all_listed(patterns.data(), patterns.size(), L',',
+                                    text.data(), text.size());
+}
+
+inline bool selected(std::string const& patterns, char const* text) {
+  // null text is matched by no pattern, so only a list without any accepts it
+  if(text == nullptr)
+    return patterns.find_first_not_of(',') == std::string::npos;
+  return detail::selected_listed(patterns.data(), patterns.size(), ',',
+                                 text, std::char_traits<char>::length(text));
+}
+
+inline bool selected(std::string const& patterns, std::string const& text) {
+  return detail::selected_listed(patterns.data(), patterns.size(), ',',
+                                 text.data(), text.size());
+}
+
+inline bool selected(std::wstring const& patterns, wchar_t const* text) {
+  // null text is matched by no pattern, so only a list without any accepts it
+  if(text == nullptr)
+    return patterns.find_first_not_of(L',') == std::wstring::npos;
+  return detail::selected_listed(patterns.data(), patterns.size(), L',',
+                                 text, std::char_traits<wchar_t>::length(text));
+}
+
+inline bool selected(std::wstring const& patterns, std::wstring const& text) {
+  return detail::selected_listed(patterns.data(), patterns.size(), L',',
+                                 text.data(), text.size());
+}
+
+inline bool selected(std::string_view patterns, std::string_view text) {
+  return detail::selected_listed(patterns.data(), patterns.size(), ',',
+                                 text.data(), text.size());
+}
+
+inline bool selected(std::wstring_view patterns, std::wstring_view text) {
+  return detail::selected_listed(patterns.data(), patterns.size(), L',',
+                                 text.data(), text.size());
 }
 
 
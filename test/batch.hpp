@@ -0,0 +1,39 @@
+#pragma once
+
+
+#include <string>
+#include <vector>
+#include <doctest/doctest.h>
+#include <chineseroom/batch.hpp>
+
+
+TEST_CASE("batch matching of texts") {
+  std::vector<std::string> texts;
+  for(int i = 0; i != 1000; ++i)
+    texts.push_back("item-" + std::to_string(i));
+  chineseroom::compiled_pattern const pattern{"item-?7"};
+
+  std::vector<std::uint64_t> bits;
+  chineseroom::matched_batch(pattern, texts, bits);
+  std::vector<std::uint64_t> parallel;
+  chineseroom::matched_batch(pattern, texts, parallel, 4);
+  REQUIRE(bits.size() == 16);
+  REQUIRE(bits == parallel);
+  for(std::size_t i = 0; i != texts.size(); ++i)
+    REQUIRE(bool((bits[i / 64] >> (i % 64)) & 1) == pattern.matched(texts[i]));
+
+  chineseroom::compiled_pattern const negated{"!item-?7"};
+  chineseroom::matched_batch(negated, texts, parallel, 3);
+  REQUIRE(parallel.back() == (~bits.back() & ((std::uint64_t(1) << (1000 % 64)) - 1)));
+}
+
+
+
+TEST_CASE("batch matching of text column") {
+  std::string const buffer{"abcabdxyzab"};
+  std::size_t const offsets[] = {0, 3, 6, 9, 11};
+  chineseroom::text_column const column{buffer.data(), offsets, 4};
+  std::vector<std::uint64_t> bits;
+  chineseroom::matched_batch(chineseroom::compiled_pattern{"ab*"}, column, bits);
+  REQUIRE(bits == std::vector<std::uint64_t>{0b1011});
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <doctest/doctest.h>
+#include <chineseroom/compiled_pattern.hpp>
+
+
+TEST_CASE("compiled pattern matching") {
+  REQUIRE(chineseroom::compiled_pattern{"ab?ba"}.matched("abcba"));
+  REQUIRE(chineseroom::compiled_pattern{"ab*ba"}.matched("abcdefba"));
+  REQUIRE(chineseroom::compiled_pattern{"*b*?d*"}.matched("abcd"));
+  REQUIRE(chineseroom::compiled_pattern{"!ab*ba"}.matched("abcdefa"));
+  REQUIRE(!chineseroom::compiled_pattern{"ab*ba"}.matched("aba"));
+  REQUIRE(!chineseroom::compiled_pattern{"ab?ba"}.matched("abba"));
+  REQUIRE(chineseroom::compiled_pattern{"a*bcd*?e"}.longest_literal() == "bcd");
+  REQUIRE(chineseroom::compiled_pattern{"*"}.matched(std::string_view{}));
+  REQUIRE(chineseroom::compiled_pattern{""}.matched(std::string_view{}));
+  REQUIRE(!chineseroom::compiled_pattern{"a*"}.matched(std::string_view{}));
+}
+
+
+
+TEST_CASE("compiled pattern search inside text") {
+  std::string_view const log{"12:00 INFO start\n12:01 ERROR disk full\n12:02 ERROR net down\n"};
+  chineseroom::compiled_pattern const errors{"ERROR ?*l"};
+  chineseroom::capture const found = errors.find(log);
+  REQUIRE(log.substr(found.offset, found.size) == "ERROR disk ful");
+  REQUIRE(errors.find(log, found.offset + 1).offset == std::string_view::npos);
+
+  std::vector<std::string_view> all;
+  chineseroom::compiled_pattern{"*12:0[12]*"}.find_all(log, [&](chineseroom::capture c) {
+    all.push_back(log.substr(c.offset, c.size));
+    return true;
+  });
+  REQUIRE(all == std::vector<std::string_view>{"12:01", "12:02"});
+}
+
+
+
+TEST_CASE("compiled pattern screening by text signature") {
+  chineseroom::text_signature const signature{"abcdefba"};
+  REQUIRE(chineseroom::compiled_pattern{"ab*ba"}.admits(signature));
+  REQUIRE(!chineseroom::compiled_pattern{"ab*xa"}.admits(signature));
+  REQUIRE(!chineseroom::compiled_pattern{"b*"}.admits(signature));
+  REQUIRE(!chineseroom::compiled_pattern{"*b"}.admits(signature));
+  REQUIRE(!chineseroom::compiled_pattern{"ab?ba"}.admits(signature));
+  REQUIRE(chineseroom::compiled_pattern{"AB*BA", chineseroom::ascii::ignore_case}.admits(signature));
+  REQUIRE(chineseroom::compiled_pattern{"!ab*xa"}.matched("abcdefba", signature));
+}
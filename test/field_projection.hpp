@@ -0,0 +1,43 @@
+#pragma once
+
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <doctest/doctest.h>
+#include <chineseroom/field_projection.hpp>
+#include <chineseroom/pattern_set.hpp>
+
+
+TEST_CASE("project fields of selected records") {
+  chineseroom::pattern_set const hosts{"*.example.com", "!test.*"};
+  chineseroom::field_projection const projection{3, {4, 1, 3}, ','};
+
+  std::vector<std::string> fields;
+  auto const collect = [&](std::size_t i, std::string_view field) {
+    fields[i] = std::string{field};
+  };
+
+  fields.assign(3, "");
+  REQUIRE(projection.select(hosts, "1,GET,www.example.com,200,512", collect));
+  REQUIRE(fields == std::vector<std::string>{"200", "1", "www.example.com"});
+
+  fields.assign(3, "");
+  REQUIRE(projection.select(hosts, "2,GET,api.example.com", collect));
+  REQUIRE(fields == std::vector<std::string>{"", "2", "api.example.com"});
+
+  REQUIRE_FALSE(projection.select(hosts, "3,GET,test.example.com,200", collect));
+  REQUIRE_FALSE(projection.select(hosts, "4,GET,example.org,200", collect));
+  REQUIRE_FALSE(projection.select(hosts, "5,www.example.com", collect));
+
+  std::string text;
+  for(int i = 0; i != 1000; ++i)
+    text += std::to_string(i) + ",GET," + (i % 4 == 0 ? "www.example.com" : "example.org")
+          + ',' + std::to_string(200 + i % 3) + '\n';
+  chineseroom::grep_options options;
+  options.chunk_size = 100;
+  options.threads = 4;
+  std::string const projected = chineseroom::project_lines(hosts, text, projection, options);
+  REQUIRE(std::count(projected.begin(), projected.end(), '\n') == 250);
+  REQUIRE(projected.substr(0, 44) == "200,0,www.example.com\n201,4,www.example.com\n");
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+
+#include <string>
+#include <doctest/doctest.h>
+#include <chineseroom/glob_map.hpp>
+
+
+TEST_CASE("glob map finds the most specific pattern") {
+  chineseroom::glob_map<std::string> const routes{
+    {"*", "default"}, {"/api/*", "api"}, {"/api/v?/users*", "users"},
+    {"/api/v1/users", "exact"}, {"*.png", "images"}, {"!/api/*", "not api"}
+  };
+
+  REQUIRE(*routes.find("/api/v1/users") == "exact");
+  REQUIRE(*routes.find("/api/v2/users/42") == "users");
+  REQUIRE(*routes.find("/api/status") == "api");
+  REQUIRE(*routes.find("/logo.png") == "images");
+  REQUIRE(*routes.find("/index.html") == "default");
+  REQUIRE(*routes.find_all("/index.html").back() == "not api");
+
+  auto const all = routes.find_all("/api/logo.png");
+  REQUIRE(all.size() == 3);
+  REQUIRE(*all[0] == "api");
+  REQUIRE(*all[1] == "images");
+  REQUIRE(*all[2] == "default");
+}
+
+
+
+TEST_CASE("glob map insertion and erasure") {
+  chineseroom::glob_map<int> map;
+  REQUIRE(map.find("abc") == nullptr);
+  map.insert_or_assign("a*", 1);
+  map.insert_or_assign("*bc*", 2);
+  REQUIRE(*map.find("abc") == 2);
+  map.insert_or_assign("a*", 3);
+  REQUIRE(map.size() == 2);
+  REQUIRE(map.erase("*bc*"));
+  REQUIRE(!map.erase("*bc*"));
+  REQUIRE(*map.find("abc") == 3);
+  REQUIRE(map.find("bcd") == nullptr);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <doctest/doctest.h>
+#include <chineseroom/grep.hpp>
+#include <chineseroom/pattern_set.hpp>
+
+
+TEST_CASE("grep lines in parallel") {
+  std::string text;
+  for(int i = 0; i != 1000; ++i)
+    text += (i % 10 == 0 ? "ERROR " : "INFO ") + std::to_string(i) + '\n';
+  text += "ERROR without new line";
+
+  chineseroom::pattern_set const errors{"ERROR *", "!* 500"};
+  chineseroom::grep_options options;
+  options.chunk_size = 100;
+  options.threads = 4;
+
+  REQUIRE(chineseroom::count_lines(errors, text, options) == 100);
+  std::vector<std::string_view> lines;
+  chineseroom::grep_lines(errors, text, [&](std::string_view line) { lines.push_back(line); }, options);
+  REQUIRE(lines.size() == 100);
+  REQUIRE(lines.front() == "ERROR 0");
+  REQUIRE(lines[50] == "ERROR 510");
+  REQUIRE(lines.back() == "ERROR without new line");
+
+  options.inverted = true;
+  REQUIRE(chineseroom::count_lines(errors, text, options) == 901);
+}
+
+
+
+TEST_CASE("grep rethrows exception of a thread to the caller") {
+  struct failing {
+    bool matched_any(std::string_view line) const {
+      if(line == "bad")
+        throw std::runtime_error{"bad line"};
+      return true;
+    }
+  };
+  std::string text;
+  for(int i = 0; i != 1000; ++i)
+    text += i == 700 ? "bad\n" : "good\n";
+  chineseroom::grep_options options;
+  options.threads = 4;
+  options.chunk_size = 64;
+  REQUIRE_THROWS_AS(chineseroom::count_lines(failing{}, text, options), std::runtime_error);
+  REQUIRE(chineseroom::count_lines(failing{}, std::string_view{"good\ngood\n"}, options) == 2);
+}
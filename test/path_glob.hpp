@@ -0,0 +1,36 @@
+#pragma once
+
+
+#include <doctest/doctest.h>
+#include <chineseroom/path_glob.hpp>
+
+
+TEST_CASE("path pattern matching") {
+  chineseroom::path_pattern const sources{"src/**/*.cpp"};
+  REQUIRE(sources.matched("src/main.cpp"));
+  REQUIRE(sources.matched("src/a/b/main.cpp"));
+  REQUIRE(!sources.matched("src/a/main.hpp"));
+  REQUIRE(!sources.matched("test/main.cpp"));
+  REQUIRE(!chineseroom::path_pattern{"src/*.cpp"}.matched("src/a/main.cpp"));
+  REQUIRE(chineseroom::path_pattern{"**/!important"}.matched("a/!important"));
+  REQUIRE(chineseroom::path_pattern{"!**/*.o"}.matched("a/b.c"));
+}
+
+
+
+TEST_CASE("path pattern pruning of directories") {
+  chineseroom::path_pattern const sources{"src/*/test/*.cpp"};
+  REQUIRE(sources.could_match_under(""));
+  REQUIRE(sources.could_match_under("src/net"));
+  REQUIRE(sources.could_match_under("src/net/test"));
+  REQUIRE(!sources.could_match_under("src/net/bench"));
+  REQUIRE(!sources.could_match_under("docs"));
+  REQUIRE(chineseroom::path_pattern{"**/*.cpp"}.could_match_under("docs/a"));
+
+  chineseroom::path_list const list{"**/*.cpp", "!build/**"};
+  REQUIRE(list.matched_any("src/main.cpp"));
+  REQUIRE(!list.matched_any("build/gen/main.cpp"));
+  REQUIRE(list.could_match_under("src"));
+  REQUIRE(!list.could_match_under("build"));
+  REQUIRE(!list.could_match_under("build/gen"));
+}
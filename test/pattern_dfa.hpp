@@ -0,0 +1,75 @@
+#pragma once
+
+
+#include <doctest/doctest.h>
+#include <chineseroom/pattern_dfa.hpp>
+
+
+TEST_CASE("pattern automaton reporting matched patterns") {
+  chineseroom::pattern_dfa const dfa{"*.example.com", "mail.*", "!*.internal.*", "*"};
+  std::vector<bool> bits;
+  dfa.matched("mail.example.com", bits);
+  REQUIRE(bits == std::vector<bool>{true, true, true, true});
+  dfa.matched("mail.internal.net", bits);
+  REQUIRE(bits == std::vector<bool>{false, true, false, true});
+
+  std::vector<std::size_t> ids;
+  dfa.matched("www.example.com", [&ids](std::size_t id) { ids.push_back(id); });
+  REQUIRE(ids == std::vector<std::size_t>{0, 2, 3});
+  REQUIRE(!dfa.matched_any("mail.internal.net"));
+}
+
+
+
+TEST_CASE("pattern automaton split by states limit") {
+  std::vector<std::string> const patterns{"*a?b*", "*b?c*", "*c?a*", "!*abc*"};
+  chineseroom::pattern_dfa const dfa{patterns, 16};
+  REQUIRE(dfa.automata() > 1);
+  REQUIRE(dfa.fallbacks() == 0);
+  std::vector<bool> bits;
+  dfa.matched("xaxbx", bits);
+  REQUIRE(bits == std::vector<bool>{true, false, false, true});
+  dfa.matched("abcab", bits);
+  REQUIRE(bits == std::vector<bool>{false, false, false, false});
+}
+
+
+
+TEST_CASE("pattern automaton with classes") {
+  chineseroom::pattern_dfa const dfa{"v[0-9].*", "v[!0-9]*", "\\*"};
+  std::vector<bool> bits;
+  dfa.matched("v2.1", bits);
+  REQUIRE(bits == std::vector<bool>{true, false, false});
+  dfa.matched("vx", bits);
+  REQUIRE(bits == std::vector<bool>{false, true, false});
+  dfa.matched("*", bits);
+  REQUIRE(bits == std::vector<bool>{false, false, true});
+}
+
+
+
+TEST_CASE("pattern automaton with pattern too large for automaton") {
+  // subset construction of '*a' followed by n '?' takes 2^n states
+  std::string const wide = "*a" + std::string(24, '?');
+  std::vector<std::string> const patterns{"x*", wide, "!*zz*", "!" + wide};
+  chineseroom::pattern_dfa const dfa{patterns};
+  REQUIRE(dfa.fallbacks() == 2);
+
+  std::string const hit = "xa" + std::string(24, '-');
+  std::string const miss = "x" + std::string(24, '-');
+  std::vector<bool> bits;
+  dfa.matched(hit, bits);
+  REQUIRE(bits == std::vector<bool>{true, true, true, false});
+  dfa.matched(miss, bits);
+  REQUIRE(bits == std::vector<bool>{true, false, true, true});
+  REQUIRE(!dfa.matched_any(hit));
+  REQUIRE(dfa.matched_any(miss));
+
+  std::vector<std::size_t> ids;
+  chineseroom::pattern_dfa::stream stream{dfa};
+  stream.feed(hit.substr(0, 5));
+  stream.feed(hit.substr(5));
+  stream.matched([&](std::size_t id) { ids.push_back(id); });
+  REQUIRE(ids == std::vector<std::size_t>{0, 1, 2});
+  REQUIRE(!stream.matched_any());
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+
+#include <string>
+#include <vector>
+#include <doctest/doctest.h>
+#include <chineseroom/pattern_image.hpp>
+#include <chineseroom/pattern_set.hpp>
+
+
+TEST_CASE("match patterns of image") {
+  namespace chr = chineseroom;
+  std::vector<std::string> const patterns{
+    "www.example.com", "*.example.org", "api.*", "*status*", "a?c*x[0-9]",
+    "!*.example.org", "!*debug*", "*", "\\*literal", "*[!a-z]end"
+  };
+  std::vector<std::string> const texts{
+    "", "www.example.com", "mail.example.org", "api.v2", "get status now",
+    "abcdx5", "abcdx", "*literal", "1end", "aend", "debug api.x", "other"
+  };
+
+  std::string const bytes = chr::pattern_image::make(patterns);
+  chr::pattern_image const image{bytes};
+  REQUIRE(image.is_open());
+  REQUIRE(image.size() == patterns.size());
+  REQUIRE(image[4] == "a?c*x[0-9]");
+
+  // subsets of patterns as a set and as an image
+  for(unsigned subset = 0; subset < 1u << patterns.size(); subset += 7) {
+    std::vector<std::string> chosen;
+    for(std::size_t i = 0; i != patterns.size(); ++i)
+      if(subset & (1u << i))
+        chosen.push_back(patterns[i]);
+    chr::pattern_set const set{chosen};
+    std::string const made = chr::pattern_image::make(chosen);
+    chr::pattern_image const each{made};
+    for(auto const& text: texts) {
+      INFO(subset << " " << text);
+      REQUIRE(each.matched_any(text) == set.matched_any(text));
+    }
+  }
+
+  std::string broken = bytes;
+  broken[8] = char(broken[8] + 1);
+  chr::pattern_image other;
+  REQUIRE_FALSE(other.open(broken));
+  REQUIRE_FALSE(other.is_open());
+  REQUIRE_FALSE(other.open(std::string_view{bytes}.substr(0, bytes.size() - 8)));
+  REQUIRE(other.open(bytes));
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+
+#include <doctest/doctest.h>
+#include <chineseroom/pattern_list.hpp>
+#include <chineseroom/wildcards.hpp>
+
+
+TEST_CASE("pattern list matching") {
+  chineseroom::pattern_list const list{std::string_view{"ab*ba,,!abcdefba,"}};
+  REQUIRE(list.size() == 2);
+  REQUIRE(list.matched_any("abcba"));
+  REQUIRE(!list.matched_any("abcdefba"));
+  REQUIRE(!list.matched_any("abc"));
+  REQUIRE(chineseroom::pattern_list{std::string_view{"!a*"}}.matched_any("b"));
+}
+
+
+
+TEST_CASE("matching comma separated patterns in place") {
+  std::string_view const spec{"*.example.com,localhost,!admin.*"};
+  REQUIRE(chineseroom::selected(spec, std::string_view{"www.example.com"}));
+  REQUIRE(chineseroom::selected(spec, std::string_view{"localhost"}));
+  REQUIRE(!chineseroom::selected(spec, std::string_view{"admin.example.com"}));
+  REQUIRE(!chineseroom::selected(spec.substr(0, 13), std::string_view{"localhost"}));
+}
+
+
+
+TEST_CASE("reordering pattern list by hits") {
+  chineseroom::pattern_list list{"a*", "b*", "!*x", "c*"};
+  chineseroom::pattern_list::statistics stats;
+  for(int i = 0; i != 10; ++i)
+    REQUIRE(list.matched_any("cat", stats));
+  REQUIRE(!list.matched_any("cox", stats));
+  REQUIRE(stats.texts == 11);
+  REQUIRE(stats.counters[3].hits == 10);
+  REQUIRE(stats.counters[2].hits == 1);
+
+  list.reorder(stats);
+  REQUIRE(list.order().front() == 3);
+  REQUIRE(list.matched_any("cat"));
+  REQUIRE(!list.matched_any("cax"));
+  REQUIRE(!list.matched_any("dog"));
+
+  chineseroom::pattern_list other{"a*", "b*", "!*x", "c*"};
+  other.reorder(stats, 42);
+  list.reorder(stats, 42);
+  REQUIRE(list.order() == other.order());
+  list.reset_order();
+  REQUIRE(list.order() == std::vector<std::uint32_t>{0, 1, 2, 3});
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <doctest/doctest.h>
+#include <chineseroom/pattern_set.hpp>
+#include <chineseroom/wildcards.hpp>
+
+
+TEST_CASE("pattern set matching") {
+  chineseroom::pattern_set const set{"*.example.com", "mail.*", "?", "!*.internal.*"};
+  REQUIRE(set.matched_any("www.example.com"));
+  REQUIRE(set.matched_any("mail.ru"));
+  REQUIRE(set.matched_any("x"));
+  REQUIRE(!set.matched_any("mail.internal.net"));
+  REQUIRE(!set.matched_any("example.org"));
+
+  REQUIRE(chineseroom::pattern_set{std::string{"ab*ba,!abcdefba"}}.matched_any("abcba"));
+  REQUIRE(!chineseroom::pattern_set{std::string{"ab*ba,!abcdefba"}}.matched_any("abcdefba"));
+}
+
+
+
+TEST_CASE("pattern set literal patterns") {
+  chineseroom::pattern_set const set{"localhost", "127.0.0.1", "*.local", "!blocked.local"};
+  REQUIRE(set.matched_any("localhost"));
+  REQUIRE(set.matched_any("printer.local"));
+  REQUIRE(!set.matched_any("localhost2"));
+  REQUIRE(!set.matched_any("blocked.local"));
+}
+
+
+
+TEST_CASE("pattern set prefix and suffix patterns") {
+  chineseroom::pattern_set const set{"api.*", "api.v2.*", "*.png", "*.min.js", "!api.*.png"};
+  REQUIRE(set.matched_any("api.v1.users"));
+  REQUIRE(set.matched_any("static/app.min.js"));
+  REQUIRE(set.matched_any("logo.png"));
+  REQUIRE(!set.matched_any("api.v2.logo.png"));
+  REQUIRE(!set.matched_any("ap.v2"));
+}
+
+
+
+TEST_CASE("pattern set insertion and removal") {
+  chineseroom::pattern_set set{"localhost", "*.local"};
+  std::uint32_t const middle = set.insert("*internal*");
+  std::uint32_t const excluded = set.insert("!*blocked*");
+  REQUIRE(set.size() == 4);
+  REQUIRE(set.matched_any("db.internal.net"));
+  REQUIRE(!set.matched_any("blocked.local"));
+
+  REQUIRE(set.remove(excluded));
+  REQUIRE(!set.remove(excluded));
+  REQUIRE(set.matched_any("blocked.local"));
+  REQUIRE(set.remove(middle));
+  REQUIRE(!set.matched_any("db.internal.net"));
+  REQUIRE(set.remove(0));
+  REQUIRE(!set.matched_any("localhost"));
+
+  REQUIRE(set.insert("localhost") == 0);
+  REQUIRE(set.matched_any("localhost"));
+  REQUIRE(set.size() == 2);
+}
+
+
+
+TEST_CASE("pattern set keeps texts of literal patterns in arena") {
+  chineseroom::pattern_set set;
+  for(int i = 0; i != 1000; ++i)
+    set.insert("same.example.com");
+  REQUIRE(set.memory().texts < 64);
+  REQUIRE(set.body(999) == "same.example.com");
+  REQUIRE(set[999].body() == "same.example.com");
+  REQUIRE(set.literal(999));
+  REQUIRE(!set.negated(999));
+
+  std::vector<std::uint32_t> ids;
+  for(int i = 0; i != 10000; ++i)
+    ids.push_back(set.insert("host-" + std::to_string(i) + ".example.com"));
+  set.insert("!blocked-*");
+  for(std::size_t i = 0; i != ids.size(); ++i)
+    if(i % 10 != 0)
+      REQUIRE(set.remove(ids[i]));
+
+  // the arena was compacted, texts of remaining patterns moved
+  REQUIRE(set.memory().texts < 10000 * 16);
+  REQUIRE(set.matched_any("host-0.example.com"));
+  REQUIRE(set.matched_any("host-9990.example.com"));
+  REQUIRE(!set.matched_any("host-9991.example.com"));
+  REQUIRE(set.matched_any("same.example.com"));
+  REQUIRE(set.size() == 1000 + 1000 + 1);
+  REQUIRE(set.memory().total() > set.memory().texts);
+}
+
+
+
+TEST_CASE("pattern set keeps empty pattern across arena compaction") {
+  chineseroom::pattern_set set{std::vector<std::string>{"", "abc"}};
+  std::vector<std::uint32_t> ids;
+  for(int i = 0; i != 2000; ++i)
+    ids.push_back(set.insert("filler" + std::to_string(i)));
+  for(std::uint32_t id: ids)
+    REQUIRE(set.remove(id));
+
+  REQUIRE(set.memory().texts < 2000 * 8);
+  REQUIRE(set.matched_any("abc"));
+  REQUIRE(set.matched_any(""));
+  REQUIRE(!set.matched_any("fil"));
+  REQUIRE(set.body(1) == "abc");
+  REQUIRE(set.body(0).empty());
+}
+
+
+
+TEST_CASE("pattern set built by several threads") {
+  std::vector<std::string> patterns;
+  for(int i = 0; i != 20000; ++i) {
+    std::string const host = "host-" + std::to_string(i % 15000);
+    switch(i % 5) {
+      case 0: patterns.push_back(host + ".example.com"); break;
+      case 1: patterns.push_back(host + "*"); break;
+      case 2: patterns.push_back("*." + host); break;
+      case 3: patterns.push_back("*" + host + "?x*"); break;
+      default: patterns.push_back("!" + host + ".example.com"); break;
+    }
+  }
+  patterns.push_back("*[0-9]");
+
+  chineseroom::pattern_set const single{patterns, 1};
+  chineseroom::pattern_set const parallel{patterns, 4};
+  chineseroom::pattern_set added;
+  for(auto const& each: patterns)
+    added.insert(each);
+
+  REQUIRE(parallel.size() == single.size());
+  REQUIRE(parallel.memory().texts == single.memory().texts);
+  REQUIRE(parallel.memory().patterns == single.memory().patterns);
+  REQUIRE(parallel.memory().indexes == single.memory().indexes);
+  for(std::uint32_t id = 0; id != single.size(); ++id)
+    REQUIRE(parallel.body(id) == single.body(id));
+
+  std::vector<std::string> const texts{
+    "host-10.example.com", "host-5.example.com", "host-11.net", "a.host-12",
+    "my-host-13-x.org", "host-14.example.com", "nothing", "host-16"
+  };
+  for(auto const& text: texts) {
+    INFO(text);
+    REQUIRE(parallel.matched_any(text) == single.matched_any(text));
+    REQUIRE(parallel.matched_any(text) == added.matched_any(text));
+  }
+}
+
+
+
+TEST_CASE("pattern index matched from a callback of another match") {
+  chineseroom::pattern_index outer;
+  chineseroom::pattern_index inner;
+  for(char const* each: {"*ab*", "*cd*", "*ef*"}) {
+    outer.insert(each);
+    inner.insert(each);
+  }
+  auto const all = [](std::uint32_t) { return true; };
+  std::vector<std::uint32_t> found;
+  std::size_t nested = 0;
+  outer.matched("ab cd ef ab cd ef", all, [&](std::uint32_t id) {
+    found.push_back(id);
+    inner.matched("ef cd ab", all, [&](std::uint32_t) { ++nested; return true; });
+    return true;
+  });
+  std::sort(found.begin(), found.end());
+  REQUIRE(found == std::vector<std::uint32_t>{0, 1, 2});
+  REQUIRE(nested == 9);
+}
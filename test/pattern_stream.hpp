@@ -0,0 +1,46 @@
+#pragma once
+
+
+#include <doctest/doctest.h>
+#include <chineseroom/pattern_dfa.hpp>
+#include <chineseroom/pattern_stream.hpp>
+
+
+TEST_CASE("pattern stream matching chunks") {
+  chineseroom::compiled_pattern const pattern{"ab*c?d*"};
+  chineseroom::pattern_stream stream{pattern};
+  stream.feed("ab");
+  REQUIRE(!stream.matched());
+  stream.feed("xxc");
+  stream.feed("");
+  stream.feed("zd");
+  REQUIRE(stream.matched());
+  stream.reset();
+  stream.feed("abd");
+  REQUIRE(!stream.matched());
+
+  chineseroom::compiled_pattern const negated{"!*x*"};
+  chineseroom::pattern_stream rejected{negated};
+  rejected.feed("ab");
+  REQUIRE(rejected.matched());
+  rejected.feed("cx");
+  REQUIRE(!rejected.matched());
+}
+
+
+
+TEST_CASE("pattern dfa stream matching chunks") {
+  chineseroom::pattern_dfa const dfa{"*.example.com", "mail.*", "!*.internal.*"};
+  chineseroom::pattern_dfa::stream stream{dfa};
+  stream.feed("www.exam");
+  stream.feed("ple.com");
+  REQUIRE(stream.matched_any());
+  std::size_t count = 0;
+  stream.matched([&count](std::size_t) { ++count; });
+  REQUIRE(count == 2);
+
+  stream.reset();
+  stream.feed("mail.inter");
+  stream.feed("nal.org");
+  REQUIRE(!stream.matched_any());
+}
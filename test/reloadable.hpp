@@ -0,0 +1,68 @@
+#pragma once
+
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <doctest/doctest.h>
+#include <chineseroom/pattern_set.hpp>
+#include <chineseroom/reloadable.hpp>
+
+
+TEST_CASE("reloadable snapshot is kept while pinned") {
+  chineseroom::reloadable<chineseroom::pattern_set> rules{chineseroom::pattern_set{"a*"}};
+  auto const reader = rules.make_reader();
+  {
+    auto const pinned = reader.pin();
+    rules.publish(chineseroom::pattern_set{"b*"});
+    REQUIRE(pinned->matched_any("abc"));
+    REQUIRE(rules.reclaim() == 1);
+    auto const other = rules.make_reader();
+    REQUIRE(other.read([](auto const& set) { return set.matched_any("bcd"); }));
+  }
+  REQUIRE(rules.reclaim() == 0);
+  REQUIRE(!reader.read([](auto const& set) { return set.matched_any("abc"); }));
+}
+
+
+
+TEST_CASE("reloadable snapshot is kept while pinned by nested reads") {
+  chineseroom::reloadable<chineseroom::pattern_set> rules{chineseroom::pattern_set{"a*"}};
+  auto const reader = rules.make_reader();
+  {
+    auto const outer = reader.pin();
+    rules.publish(chineseroom::pattern_set{"b*"});
+    REQUIRE(reader.read([](auto const& set) { return set.matched_any("bcd"); }));
+    rules.publish(chineseroom::pattern_set{"c*"});
+    REQUIRE(rules.reclaim() == 2);
+    REQUIRE(outer->matched_any("abc"));
+  }
+  REQUIRE(rules.reclaim() == 0);
+}
+
+
+
+TEST_CASE("reloadable snapshot is replaced while read by threads") {
+  chineseroom::reloadable<chineseroom::pattern_set> rules{chineseroom::pattern_set{"a*", "!*x"}};
+  std::atomic<bool> stopped{false};
+  std::atomic<int> wrong{0};
+  std::vector<std::thread> threads;
+
+  for(int i = 0; i != 4; ++i)
+    threads.emplace_back([&] {
+      auto const reader = rules.make_reader();
+      while(!stopped.load())
+        if(!reader.read([](auto const& set) { return set.matched_any("abc"); }))
+          ++wrong;
+    });
+
+  for(int i = 0; i != 200; ++i)
+    rules.publish(chineseroom::pattern_set{"a*", "!*x", i % 2 ? "*c" : "*b"});
+
+  stopped = true;
+  for(auto& each: threads)
+    each.join();
+
+  REQUIRE(wrong.load() == 0);
+  REQUIRE(rules.reclaim() == 0);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+
+#include <string_view>
+#include <doctest/doctest.h>
+#include <chineseroom/compiled_pattern.hpp>
+#include <chineseroom/static_pattern.hpp>
+
+
+namespace static_patterns {
+
+  namespace chr = chineseroom;
+
+  constexpr chr::static_pattern literal{"abba"};
+  constexpr chr::static_pattern stars{"ab*ba"};
+  constexpr chr::static_pattern pieces{"*a?*[b-c]a*[!x]"};
+  constexpr chr::static_pattern negated{"!*.tmp"};
+  constexpr chr::static_pattern escaped{"\\*a\\?*"};
+  constexpr chr::static_pattern unclosed{"a[b"};
+  constexpr chr::static_pattern folded{"AB*b[A]", chr::ascii::ignore_case};
+
+  static_assert(stars.pieces() == 2 && stars.min_length() == 4);
+  static_assert(!literal.starred() && literal.exact(0));
+  static_assert(negated.negated() && !pieces.exact(1));
+
+
+  template<auto const& P>
+  void compare(std::string_view pattern, chr::compiled_pattern const& compiled) {
+    std::string_view const texts[] = {
+      "", "a", "ab", "aba", "abba", "abbba", "ABBA", "abcba", "abab",
+      "xaybaz", "xaybax", "aab", "aba", "a.tmp", "b.tmp.x", "*a?", "*a?b",
+      "a[b", "a[bb", "abBA", "ABxba", "abxbA", "zabca"
+    };
+    for(std::string_view const text: texts) {
+      INFO(pattern << " " << text);
+      REQUIRE(chr::matched<P>(text) == compiled.matched(text));
+    }
+  }
+
+} // static_patterns
+
+
+TEST_CASE("match patterns parsed during compilation") {
+  namespace chr = chineseroom;
+  using namespace static_patterns;
+
+  REQUIRE(chr::matched<stars>("abba"));
+  REQUIRE(chr::matched<stars>("abcba"));
+  REQUIRE_FALSE(chr::matched<stars>("aba"));
+  REQUIRE(chr::matched<folded>("abxbA"));
+
+  compare<literal>("abba", chr::compiled_pattern{"abba"});
+  compare<stars>("ab*ba", chr::compiled_pattern{"ab*ba"});
+  compare<pieces>("*a?*[b-c]a*[!x]", chr::compiled_pattern{"*a?*[b-c]a*[!x]"});
+  compare<negated>("!*.tmp", chr::compiled_pattern{"!*.tmp"});
+  compare<escaped>("\\*a\\?*", chr::compiled_pattern{"\\*a\\?*"});
+  compare<unclosed>("a[b", chr::compiled_pattern{"a[b"});
+  compare<folded>("AB*b[A]", chr::compiled_pattern{"AB*b[A]", chr::ascii::ignore_case});
+}
@@ -4,3 +4,17 @@
 #include "split.hpp"
 #include "wildcards.hpp"
 #include "replace.hpp"
+#include "compiled_pattern.hpp"
+#include "pattern_set.hpp"
+#include "pattern_dfa.hpp"
+#include "pattern_list.hpp"
+#include "reloadable.hpp"
+#include "glob_map.hpp"
+#include "topic_router.hpp"
+#include "path_glob.hpp"
+#include "pattern_stream.hpp"
+#include "batch.hpp"
+#include "grep.hpp"
+#include "field_projection.hpp"
+#include "static_pattern.hpp"
+#include "pattern_image.hpp"
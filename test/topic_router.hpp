@@ -0,0 +1,44 @@
+#pragma once
+
+
+#include <algorithm>
+#include <vector>
+#include <doctest/doctest.h>
+#include <chineseroom/topic_router.hpp>
+
+
+TEST_CASE("topic router matching") {
+  chineseroom::topic_router<int> router;
+  REQUIRE(router.subscribe("orders.eu.new", 1));
+  REQUIRE(router.subscribe("orders.*.new", 2));
+  REQUIRE(router.subscribe("orders.>", 3));
+  REQUIRE(router.subscribe("orders.**", 4));
+  REQUIRE(router.subscribe("*", 5));
+  REQUIRE(!router.subscribe("orders.>.new", 6));
+  REQUIRE(router.size() == 5);
+
+  auto sorted = [&router](std::string_view subject) {
+    std::vector<int> matched = router.matched(subject);
+    std::sort(matched.begin(), matched.end());
+    return matched;
+  };
+
+  REQUIRE(sorted("orders.eu.new") == std::vector<int>{1, 2, 3, 4});
+  REQUIRE(sorted("orders.us.new") == std::vector<int>{2, 3, 4});
+  REQUIRE(sorted("orders.us") == std::vector<int>{3, 4});
+  REQUIRE(sorted("orders") == std::vector<int>{4, 5});
+  REQUIRE(sorted("payments.eu") == std::vector<int>{});
+}
+
+
+
+TEST_CASE("topic router unsubscription") {
+  chineseroom::topic_router<int> router{'/'};
+  router.subscribe("a/*/c", 1);
+  router.subscribe("a/*/c", 2);
+  REQUIRE(router.unsubscribe("a/*/c", 1));
+  REQUIRE(!router.unsubscribe("a/*/c", 1));
+  REQUIRE(!router.unsubscribe("a/b/c", 2));
+  REQUIRE(router.matched("a/b/c") == std::vector<int>{2});
+  REQUIRE(router.size() == 1);
+}
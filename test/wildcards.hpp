@@ -4,6 +4,7 @@
 
 #include <doctest/doctest.h>
 #include <chineseroom/wildcards.hpp>
+#include <chineseroom/compiled_pattern.hpp>
 
 
 TEST_CASE("checking wildcards") {
@@ -25,4 +26,76 @@ TEST_CASE("pattern matching") {
   REQUIRE(!chineseroom::matched("ab?ba", "abba"));
   REQUIRE(!chineseroom::matched("ab*ba", "abcdefa"));
   REQUIRE(!chineseroom::matched_any(std::string{"ab*ba,!abcdefba"}, "abcdefba"));
+  char const* const null_text = nullptr;
+  REQUIRE(!chineseroom::matched_any(std::string{"*,!ab"}, null_text));
+  REQUIRE(chineseroom::matched_any(std::string{",,"}, null_text));
+}
+
+
+
+TEST_CASE("matching every pattern and selecting by patterns") {
+  // every pattern has to match
+  REQUIRE(!chineseroom::matched_any({"a*", "b*"}, "abc"));
+  REQUIRE(!chineseroom::matched_any(std::string{"a*,b*"}, "abc"));
+  REQUIRE(chineseroom::matched_any({"a*", "*c", "!b*"}, "abc"));
+  // any pattern without '!' selects, any '!' pattern rejects
+  REQUIRE(chineseroom::selected({"a*", "b*"}, "abc"));
+  REQUIRE(chineseroom::selected(std::string{"a*,b*"}, "abc"));
+  REQUIRE(!chineseroom::selected({"a*", "!*c"}, "abc"));
+  REQUIRE(chineseroom::selected(std::string{"!b*"}, "abc"));
+}
+
+
+
+TEST_CASE("pattern matching without NUL termination") {
+  std::string_view const frame{"GET /index.html HTTP/1.1"};
+  std::string_view const path = frame.substr(4, 11);
+  REQUIRE(chineseroom::matched(std::string_view{"/*.html"}, path));
+  REQUIRE(!chineseroom::matched(std::string_view{"/*.h"}, path));
+  REQUIRE(chineseroom::matched("*.htmlx", 6, path.data(), path.size()));
+  REQUIRE(chineseroom::has_wildcards(std::string_view{"ab*"}.substr(0, 3)));
+  REQUIRE(!chineseroom::has_wildcards(std::string_view{"ab*"}.substr(0, 2)));
+}
+
+
+
+TEST_CASE("pattern matching ignoring case") {
+  using chineseroom::ascii::ignore_case;
+  REQUIRE(chineseroom::matched("*.EXAMPLE.com", "www.example.COM", ignore_case));
+  REQUIRE(chineseroom::matched("content-*", "Content-Type", ignore_case));
+  REQUIRE(!chineseroom::matched("content-*", "Content-Type"));
+  REQUIRE(!chineseroom::matched("!x-*", "X-Forwarded-For", ignore_case));
+  REQUIRE(chineseroom::compiled_pattern("*-forwarded-*", ignore_case).matched("X-Forwarded-For"));
+  REQUIRE(!chineseroom::compiled_pattern("*-forwarded-?", ignore_case).matched("X-Forwarded-For"));
+}
+
+
+
+TEST_CASE("pattern matching with classes and escapes") {
+  REQUIRE(chineseroom::matched("id-[0-9][0-9]", "id-42"));
+  REQUIRE(!chineseroom::matched("id-[0-9][0-9]", "id-4x"));
+  REQUIRE(chineseroom::matched("[!abc]*", "dog"));
+  REQUIRE(!chineseroom::matched("[!abc]*", "cat"));
+  REQUIRE(chineseroom::matched("[]]", "]"));
+  REQUIRE(chineseroom::matched("a\\*b", "a*b"));
+  REQUIRE(!chineseroom::matched("a\\*b", "axb"));
+  REQUIRE(chineseroom::matched("[ab", "[ab"));
+  REQUIRE(chineseroom::has_wildcards("[a-z]"));
+  REQUIRE(chineseroom::compiled_pattern{"*.[ch]pp"}.matched("split.hpp"));
+  REQUIRE(chineseroom::compiled_pattern{"[A-Z]*", chineseroom::ascii::ignore_case}.matched("lower"));
+}
+
+
+
+TEST_CASE("pattern matching with captures") {
+  std::array<chineseroom::capture, 2> captures;
+  REQUIRE(chineseroom::match_captures("user-*-session-?", "user-42-session-7", captures));
+  REQUIRE(captures[0].offset == 5);
+  REQUIRE(captures[0].size == 2);
+  REQUIRE(captures[1].offset == 16);
+  REQUIRE(captures[1].size == 1);
+  REQUIRE(chineseroom::compiled_pattern{"*.[ch]"}.match_captures("a.b.c", captures));
+  REQUIRE(captures[0].size == 3);
+  REQUIRE(captures[1].offset == 4);
+  REQUIRE(!chineseroom::match_captures("user-*-session-?", "user-42", captures));
 }